@@ -0,0 +1,123 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include "SimdKernels.h"
+
+// Activation functions the network can use.
+// The error is the largest absolute difference from the exact function (in double precision) over -100 to 100.
+// The speed is millions of values per second applied to 14 neuron layers with the scalar kernels / the AVX2 kernels.
+// 'ga1benchmark activations' measures both on your own CPU.  Use these to choose the trade-off per experiment
+enum class ActivationFunction {
+	afSigmoid,				// Exact sigmoid.                                      error 8.9e-8   73 / 325 M/s
+	afSigmoidLUT,			// Sigmoid from a lookup table, linearly interpolated  error 9.5e-7   740 M/s
+	afSigmoidRational,		// Sigmoid from a 7/6 Pade (rational) tanh             error 4.8e-5   720 M/s
+	afSigmoidPolynomial,	// Sigmoid using a cubic polynomial for 2^x            error 3.8e-5   330 M/s
+	afTanh,					// Hyperbolic tangent, output is -1 to 1               error 1.8e-7   77 / 195 M/s
+	afReLU,					// max(0, x).  The output is unbounded                 exact          1600 M/s
+	afLeakyReLU				// x when positive, otherwise 0.01x                    error 5.0e-8   1700 M/s
+};
+
+// Applies the activation functions to a layer of neuron values
+class Activation {
+private:
+	// The lookup table covers -lutRange to lutRange, outside of that the sigmoid is within 1.2e-7 of 0 or 1
+	static constexpr float lutRange = 16.0f;
+	static constexpr int lutStepsPerUnit = 128;
+	static constexpr int lutSize = (int)(lutRange * 2 * lutStepsPerUnit) + 2;
+
+	// Returns the sigmoid table, built on first use
+	static const float* sigmoidTable() {
+		static const std::vector<float> table = []() {
+			std::vector<float> values(lutSize);
+			for (int index = 0; index < lutSize; index++)
+				values[index] = SimdKernels::sigmoid(((float)index / (float)lutStepsPerUnit) - lutRange);
+			return values;
+		}();
+		return table.data();
+	}
+
+	static void sigmoidLUT(float* values, size_t count) {
+		const float* table = sigmoidTable();
+		for (size_t index = 0; index < count; index++) {
+			float position = (values[index] + lutRange) * lutStepsPerUnit;
+			if (position < 0) position = 0;
+			if (position > (float)(lutSize - 2)) position = (float)(lutSize - 2);
+			const int entry = (int)position;
+			const float fraction = position - (float)entry;
+			values[index] = table[entry] + (fraction * (table[entry + 1] - table[entry]));
+		}
+	}
+
+	// tanh(x) as a rational function.  Beyond +/-rationalLimit it is indistinguishable from +/-1 in a float
+	static constexpr float rationalLimit = 9.0f;
+	static float tanhRational(float x) {
+		if (x > rationalLimit) x = rationalLimit;
+		if (x < -rationalLimit) x = -rationalLimit;
+		const float x2 = x * x;
+		const float result = (x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)))) / (135135.0f + x2 * (62370.0f + x2 * (3150.0f + x2 * 28.0f)));
+		return result > 1.0f ? 1.0f : (result < -1.0f ? -1.0f : result);
+	}
+	static void sigmoidRational(float* values, size_t count) {
+		// sigmoid(x) = 0.5 + 0.5 * tanh(x/2)
+		for (size_t index = 0; index < count; index++)
+			values[index] = 0.5f + (0.5f * tanhRational(values[index] * 0.5f));
+	}
+
+	// sigmoid(x) = 1 / (1 + 2^(-x * log2(e))), where 2^f for the fractional part comes from a cubic polynomial
+	static void sigmoidPolynomial(float* values, size_t count) {
+		for (size_t index = 0; index < count; index++) {
+			float power = values[index] * -1.44269504088896341f;
+			if (power < -126.0f) power = -126.0f;
+			if (power > 126.0f) power = 126.0f;
+			const float whole = floorf(power);
+			const float f = power - whole;
+			const float mantissa = 1.0f + f * (0.6960656421638072f + f * (0.224494337302845f + f * 0.07944023841053369f));
+			const int32_t bits = ((int32_t)whole + 127) << 23;
+			float scale;
+			memcpy(&scale, &bits, sizeof(scale));
+			values[index] = 1.0f / (1.0f + (mantissa * scale));
+		}
+	}
+
+	static void tanh(float* values, size_t count) {
+		// tanh(x) = 2 * sigmoid(2x) - 1 so it can use the SIMD sigmoid
+		for (size_t index = 0; index < count; index++) values[index] *= 2.0f;
+		SimdKernels::sigmoid(values, count);
+		for (size_t index = 0; index < count; index++) values[index] = (values[index] * 2.0f) - 1.0f;
+	}
+
+	static void relu(float* values, size_t count) {
+		for (size_t index = 0; index < count; index++)
+			values[index] = values[index] > 0.0f ? values[index] : 0.0f;
+	}
+
+	static void leakyRelu(float* values, size_t count) {
+		for (size_t index = 0; index < count; index++)
+			values[index] = values[index] > 0.0f ? values[index] : values[index] * 0.01f;
+	}
+
+public:
+	// Apply the activation function to all of the values
+	static void apply(ActivationFunction function, float* values, size_t count) {
+		switch (function) {
+		case ActivationFunction::afSigmoid:				SimdKernels::sigmoid(values, count); break;
+		case ActivationFunction::afSigmoidLUT:			sigmoidLUT(values, count); break;
+		case ActivationFunction::afSigmoidRational:		sigmoidRational(values, count); break;
+		case ActivationFunction::afSigmoidPolynomial:	sigmoidPolynomial(values, count); break;
+		case ActivationFunction::afTanh:				tanh(values, count); break;
+		case ActivationFunction::afReLU:				relu(values, count); break;
+		case ActivationFunction::afLeakyReLU:			leakyRelu(values, count); break;
+		}
+	}
+};
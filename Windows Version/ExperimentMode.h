@@ -0,0 +1,65 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "LifeForm.h"
+
+// Everything that differs between the experiments.  Simulation, LifeForm and Population take one of these as a template
+// parameter, so all of the experiments are built into the program and the code for anything a mode doesn't use is
+// compiled out, just as it was when these were #defines.  Use ExperimentMode<MODE1> to ExperimentMode<MODE4>
+template<int Number>
+struct ExperimentMode;
+
+// What each experiment has unless it says otherwise
+struct ExperimentDefaults {
+	static constexpr bool useSolar = false;			// Lifeforms need sunlight as well as batteries
+	static constexpr bool hasQuickSand = false;		// There's quicksand about that slows them down
+	static constexpr bool trackOthers = false;		// Lifeforms can see if others are after their battery, and shield it
+	static constexpr ResourceType notConsumable = ResourceType::rtNone;
+	static constexpr int numCells = MAX_CELLS;
+	static constexpr float maxFitness = 3.0f;
+};
+
+// 1. Looking for Batteries
+template<>
+struct ExperimentMode<1> : public ExperimentDefaults {
+	static constexpr int number = 1;
+	static std::vector<size_t> networkLayers() { return { 5, 14, 12, 2 }; }
+};
+
+// 2. Looking for Solar Electricity and Batteries
+template<>
+struct ExperimentMode<2> : public ExperimentDefaults {
+	static constexpr int number = 2;
+	static constexpr bool useSolar = true;
+	static constexpr bool multiplyFitness = false;	// Fitness multiplies the sun and battery left rather than adding them
+	static constexpr ResourceType notConsumable = ResourceType::rtSunlight;
+	static constexpr float maxFitness = multiplyFitness ? 3.0f : 4.0f;
+	static std::vector<size_t> networkLayers() { return { 8, 14, 12, 2 }; }
+};
+
+// 3. Batteries and Quicksand
+template<>
+struct ExperimentMode<3> : public ExperimentDefaults {
+	static constexpr int number = 3;
+	static constexpr bool hasQuickSand = true;
+	static constexpr ResourceType notConsumable = ResourceType::rtQuickSand;
+	static std::vector<size_t> networkLayers() { return { 8, 14, 12, 2 }; }
+};
+
+// 4. Batteries and Shields
+template<>
+struct ExperimentMode<4> : public ExperimentDefaults {
+	static constexpr int number = 4;
+	static constexpr bool trackOthers = true;
+	static constexpr int numCells = 10;
+	static std::vector<size_t> networkLayers() { return { 9, 16, 14, 10, 4 }; }
+};
@@ -0,0 +1,181 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "Random.h"
+
+// Map of the room left in the area things are placed in.  The area is cut into equal cells, each knowing which resources
+// overlap it and how many cover it completely.  The cells that aren't completely covered are kept in a list, so a free
+// spot is found by picking one of them at random and a random point in it, and only the resources overlapping that cell
+// need checking.  As the cells are all the same size this picks uniformly from the free space, the same as trying random
+// points anywhere in the area until one is clear, but without trying the parts that are known to be full.
+// Each cell's list of overlapping items is linked through a block of links owned by the item, sized for the most cells an
+// item that big can reach.  Resources keep their size, so once they've all been added moving them never allocates memory.
+// A resource covers the points where the whole pixel distances to its centre are within its radius, see Simulation::resourceContains()
+class FreeSpace {
+private:
+	struct Item {
+		float x, y;
+		int radius = -1;			// -1 when it isn't in the map
+		int firstLink = 0;			// The item's block of links in m_links
+		int numLinks = 0;			// Size of the block
+		int linksUsed = 0;			// Number of cells it's in at the moment
+	};
+
+	// An item in a cell's list
+	struct Link {
+		int item;
+		int cell;
+		int next, previous;			// Other links in the same cell, or -1
+	};
+
+	float m_left, m_top;
+	float m_cellWidth, m_cellHeight;
+	int m_columns, m_rows;
+	std::vector<int> m_overlapping;					// First link in the list of items overlapping each cell, or -1
+	std::vector<Link> m_links;
+	std::vector<int> m_covering;					// Number of items covering each cell completely
+	std::vector<int> m_open;						// Cells that aren't completely covered
+	std::vector<int> m_openSlot;					// Where each cell is in m_open, or -1
+	std::vector<Item> m_items;
+
+	// Range of cells [first, last] an item could reach along one axis.  Points up to radius+1 away can round down to radius
+	static void cellRange(const float centre, const int radius, const float start, const float cellSize, const int count, int& first, int& last) {
+		const float low = (centre - (radius + 1) - start) / cellSize;
+		const float high = (centre + (radius + 1) - start) / cellSize;
+		first = low < 0 ? 0 : (int)low;
+		last = high >= count ? count - 1 : (int)high;
+	}
+
+	// TRUE if every point in the cell is well inside the item
+	bool covers(const Item& item, const int column, const int row) const {
+		const float left = m_left + (column * m_cellWidth), top = m_top + (row * m_cellHeight);
+		const float dx = std::max(std::abs(left - item.x), std::abs(left + m_cellWidth - item.x));
+		const float dy = std::max(std::abs(top - item.y), std::abs(top + m_cellHeight - item.y));
+		return (dx * dx) + (dy * dy) <= (float)item.radius * (float)item.radius;
+	}
+
+	void openCell(const int cell) {
+		m_openSlot[cell] = (int)m_open.size();
+		m_open.push_back(cell);
+	}
+
+	void closeCell(const int cell) {
+		const int slot = m_openSlot[cell];
+		m_openSlot[m_open.back()] = slot;
+		m_open[slot] = m_open.back();
+		m_open.pop_back();
+		m_openSlot[cell] = -1;
+	}
+
+public:
+	// The area starts at (left, top).  Cells are no smaller than cellSize unless the area is, they're stretched until a whole
+	// number of them fill it
+	FreeSpace(const float left, const float top, const float width, const float height, const int cellSize) : m_left(left), m_top(top) {
+		m_columns = (int)(width / cellSize);
+		m_rows = (int)(height / cellSize);
+		if (m_columns < 1) m_columns = 1;
+		if (m_rows < 1) m_rows = 1;
+		m_cellWidth = width / (float)m_columns;
+		m_cellHeight = height / (float)m_rows;
+
+		const size_t numCells = (size_t)m_columns * (size_t)m_rows;
+		m_overlapping.resize(numCells, -1);
+		m_covering.resize(numCells, 0);
+		m_openSlot.resize(numCells);
+		m_open.reserve(numCells);
+		for (size_t cell = 0; cell < numCells; cell++) openCell((int)cell);
+	}
+
+	// Add an item (a resource index) centred at (x, y)
+	void add(const int item, const float x, const float y, const int radius) {
+		if (item >= (int)m_items.size()) m_items.resize(item + 1);
+		Item& added = m_items[item];
+		added.x = x;
+		added.y = y;
+		added.radius = radius;
+
+		int firstColumn, lastColumn, firstRow, lastRow;
+		cellRange(x, radius, m_left, m_cellWidth, m_columns, firstColumn, lastColumn);
+		cellRange(y, radius, m_top, m_cellHeight, m_rows, firstRow, lastRow);
+
+		// The block is made big enough for the most cells it could reach wherever it is, so it's only needed the first time
+		const int needed = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+		if (needed > added.numLinks) {
+			const int columnsReached = std::min((int)(((radius + 1) * 2) / m_cellWidth) + 2, m_columns);
+			const int rowsReached = std::min((int)(((radius + 1) * 2) / m_cellHeight) + 2, m_rows);
+			added.firstLink = (int)m_links.size();
+			added.numLinks = std::max(needed, columnsReached * rowsReached);
+			m_links.resize(m_links.size() + added.numLinks);
+		}
+		added.linksUsed = 0;
+		for (int row = firstRow; row <= lastRow; row++)
+			for (int column = firstColumn; column <= lastColumn; column++) {
+				const int cell = (row * m_columns) + column;
+				const int linkIndex = added.firstLink + added.linksUsed++;
+				Link& link = m_links[linkIndex];
+				link.item = item;
+				link.cell = cell;
+				link.previous = -1;
+				link.next = m_overlapping[cell];
+				if (link.next >= 0) m_links[link.next].previous = linkIndex;
+				m_overlapping[cell] = linkIndex;
+				if (covers(added, column, row) && (m_covering[cell]++ == 0)) closeCell(cell);
+			}
+	}
+
+	// Take an item out again
+	void remove(const int item) {
+		Item& removed = m_items[item];
+		if (removed.radius < 0) return;
+
+		int firstColumn, lastColumn, firstRow, lastRow;
+		cellRange(removed.x, removed.radius, m_left, m_cellWidth, m_columns, firstColumn, lastColumn);
+		cellRange(removed.y, removed.radius, m_top, m_cellHeight, m_rows, firstRow, lastRow);
+		for (int row = firstRow; row <= lastRow; row++)
+			for (int column = firstColumn; column <= lastColumn; column++) {
+				const int cell = (row * m_columns) + column;
+				if (covers(removed, column, row) && (--m_covering[cell] == 0)) openCell(cell);
+			}
+
+		// Unlink it from each of the cells
+		for (int linkIndex = removed.firstLink; linkIndex < removed.firstLink + removed.linksUsed; linkIndex++) {
+			const Link& link = m_links[linkIndex];
+			if (link.previous >= 0) m_links[link.previous].next = link.next;
+			else m_overlapping[link.cell] = link.next;
+			if (link.next >= 0) m_links[link.next].previous = link.previous;
+		}
+		removed.linksUsed = 0;
+		removed.radius = -1;
+	}
+
+	// Pick a random point (x, y) where isInside(item) is FALSE for everything overlapping it.  isInside is called after
+	// x and y are set.  Returns FALSE if everywhere is covered
+	template<typename F>
+	bool sample(RandomStream& random, float& x, float& y, F isInside) const {
+		while (!m_open.empty()) {
+			const int cell = m_open[random.nextIndex(m_open.size())];
+			x = m_left + (((cell % m_columns) + random.nextFloat()) * m_cellWidth);
+			y = m_top + (((cell / m_columns) + random.nextFloat()) * m_cellHeight);
+
+			bool clear = true;
+			for (int link = m_overlapping[cell]; link >= 0; link = m_links[link].next)
+				if (isInside(m_links[link].item)) {
+					clear = false;
+					break;
+				}
+			if (clear) return true;
+		}
+		return false;
+	}
+};
@@ -18,17 +18,75 @@ struct NetworkWeightFitness {
 	float fitness;
 };
 
+// Two population sized buffers of genomes.  The networks run from the current one while the next generation
+// is written into the other, and then they swap.  Once sized, producing a generation doesn't allocate any memory
+class GenomePool {
+private:
+	std::vector<float> m_buffers[2];
+	size_t m_current = 0;
+	size_t m_populationSize = 0;
+	size_t m_genomeSize = 0;
+
+public:
+	// Returns TRUE if the pool is already the right size for this population
+	bool matches(const size_t populationSize, const size_t genomeSize) const {
+		return (m_populationSize == populationSize) && (m_genomeSize == genomeSize);
+	}
+
+	// Size the pool.  There's one spare genome in each buffer as children are made in pairs
+	void resize(const size_t populationSize, const size_t genomeSize) {
+		m_populationSize = populationSize;
+		m_genomeSize = genomeSize;
+		for (std::vector<float>& buffer : m_buffers)
+			buffer.assign((populationSize + 1) * genomeSize, 0.0f);
+	}
+
+	// A genome in the current generation
+	GenomeView current(const size_t index) {
+		return GenomeView(m_buffers[m_current].data() + (index * m_genomeSize), m_genomeSize);
+	}
+
+	// A genome in the generation being produced
+	GenomeView next(const size_t index) {
+		return GenomeView(m_buffers[m_current ^ 1].data() + (index * m_genomeSize), m_genomeSize);
+	}
+
+	// The next generation becomes the current one
+	void swap() {
+		m_current ^= 1;
+	}
+};
+
+// How parents are picked for the next generation.  All of them pick in proportion to fitness
+enum class SelectionMethod {
+	smRoulette,					// Walk the population until the running total passes a random point. O(n) per pick
+	smPrefixSum,				// Same picks as smRoulette, but binary searches a table of running totals. O(log n) per pick
+	smAlias,					// Walker/Vose alias table built once per generation. O(1) per pick
+	smStochasticUniversal		// Stochastic universal sampling. All parents picked in one pass with evenly spaced pointers
+};
+
 // Genetic algorithm main class - implements a basic genetic algorithm.
 class GeneticAlgorithm {
 	size_t m_numBest = 1;             // The best numBest networks will automatically be output into the next generation as they currently are
 	float m_crossOverRate = 0.7f;     // The % of children, that are NOT just a clone of a parent
 	float m_mutationRate = 0.1f;      // The % of chomosomes (weights) that will get mutated
 	float m_mutationAmount = 0.3f;    // The amount of mutation that may be applied to a weight
-	int m_mutationRateForRandom = 0;  // Is calculated as m_mutationRate * RAND_MAX
+	uint64_t m_seed = 0;              // The run seed the random streams are made from
+	uint64_t m_generation = 0;        // Number of generations produced so far
+	GenomePool m_pool;                // Where the genomes for the networks live
+	SelectionMethod m_selection = SelectionMethod::smPrefixSum;  // How parents are chosen
+
+	// Tables used by the selection methods.  These are re-built each generation but only allocated once
+	std::vector<float> m_runningTotal;        // smPrefixSum/smStochasticUniversal: the total fitness up to and including each parent
+	std::vector<float> m_aliasProbability;    // smAlias: chance of keeping the slot rather than taking its alias
+	std::vector<size_t> m_alias;              // smAlias: the other parent sharing each slot
+	std::vector<size_t> m_aliasSmall, m_aliasLarge;  // smAlias: work lists used while building the table
+	std::vector<size_t> m_sampled;            // smStochasticUniversal: the parents picked for this generation
+
 
 	// Picks a random parent randomly, but bias slightly based on their fitness
-	const NetworkWeightFitness* pickParentByRoulette(const std::vector< NetworkWeightFitness >& parents, const float totalFitness) const {
-		float randValue = (float)rand() * totalFitness / (float)RAND_MAX;
+	const NetworkWeightFitness* pickParentByRoulette(const std::vector< NetworkWeightFitness >& parents, const float totalFitness, RandomStream& random) const {
+		float randValue = random.nextFloat() * totalFitness;
 		float soFar = 0;
 
 		// Search for the correct one
@@ -43,39 +101,150 @@ class GeneticAlgorithm {
 		return &parents[parents.size()-1];
 	}
 
-	// Mutate the supplied weights
-	void mutateWeights(std::vector<float>& weights) const {
-		for (float& weight : weights)
-			if (rand() < m_mutationRateForRandom) // Should we mutate?
-				weight += m_mutationAmount * (((rand() * 2.0f) / (float)RAND_MAX) - 1.0f);
-	}
+	// Builds the tables needed by the selection method for this generation
+	void prepareSelection(const std::vector< NetworkWeightFitness >& parents, const float totalFitness, const size_t numPicks) {
+		const size_t count = parents.size();
+		RandomStream random(m_seed, RandomPurpose::rpSelection, 0, m_generation);
+
+		switch (m_selection) {
+		case SelectionMethod::smRoulette:
+			break;
 
-	// Create a child from the supplied parents
-	void reproduce(const std::vector<float>& parent1Weights, const std::vector<float>& parent2Weights, std::vector<float>& child1Weights, std::vector<float>& child2Weights) const {
-		const size_t point = (rand() * parent1Weights.size()) / RAND_MAX;
-		for (size_t weight = 0; weight < parent1Weights.size(); weight++) {
-			if (weight < point) {
-				child1Weights.push_back(parent1Weights[weight]);
-				child2Weights.push_back(parent2Weights[weight]);
+		case SelectionMethod::smPrefixSum:
+		case SelectionMethod::smStochasticUniversal: {
+			// Totalled in the same order as the roulette so the picks are the same
+			m_runningTotal.resize(count);
+			float soFar = 0;
+			for (size_t position = 0; position < count; position++) {
+				soFar += parents[position].fitness;
+				m_runningTotal[position] = soFar;
 			}
-			else {
-				child1Weights.push_back(parent2Weights[weight]);
-				child2Weights.push_back(parent1Weights[weight]);
+			if (m_selection == SelectionMethod::smPrefixSum) break;
+
+			// Evenly spaced pointers from a single random start
+			m_sampled.resize(numPicks);
+			if ((totalFitness <= 0) || (numPicks < 1)) {
+				for (size_t pick = 0; pick < numPicks; pick++) m_sampled[pick] = random.nextIndex(count);
+				break;
+			}
+			const double spacing = (double)totalFitness / (double)numPicks;
+			double pointer = random.nextDouble() * spacing;
+			size_t position = 0;
+			for (size_t pick = 0; pick < numPicks; pick++, pointer += spacing) {
+				while ((position < count - 1) && ((double)m_runningTotal[position] < pointer)) position++;
+				m_sampled[pick] = position;
 			}
+
+			// Shuffle them, otherwise parents would always be paired with their neighbours
+			for (size_t pick = numPicks - 1; pick > 0; pick--)
+				std::swap(m_sampled[pick], m_sampled[random.nextIndex(pick + 1)]);
+			break;
+		}
+
+		case SelectionMethod::smAlias: {
+			// Vose's method. Each slot holds one parent plus (optionally) an alias to top it up to an average share
+			m_aliasProbability.resize(count);
+			m_alias.resize(count);
+			m_aliasSmall.clear();
+			m_aliasLarge.clear();
+			m_aliasSmall.reserve(count);
+			m_aliasLarge.reserve(count);
+
+			for (size_t position = 0; position < count; position++) {
+				m_alias[position] = position;
+				m_aliasProbability[position] = (totalFitness > 0) ? (parents[position].fitness * (float)count) / totalFitness : 1.0f;
+				if (m_aliasProbability[position] < 1.0f) m_aliasSmall.push_back(position); else m_aliasLarge.push_back(position);
+			}
+
+			while ((!m_aliasSmall.empty()) && (!m_aliasLarge.empty())) {
+				const size_t small = m_aliasSmall.back(); m_aliasSmall.pop_back();
+				const size_t large = m_aliasLarge.back(); m_aliasLarge.pop_back();
+				m_alias[small] = large;
+				m_aliasProbability[large] -= 1.0f - m_aliasProbability[small];
+				if (m_aliasProbability[large] < 1.0f) m_aliasSmall.push_back(large); else m_aliasLarge.push_back(large);
+			}
+
+			// Anything left over is only there due to rounding errors and should always be chosen
+			for (size_t position : m_aliasSmall) m_aliasProbability[position] = 1.0f;
+			for (size_t position : m_aliasLarge) m_aliasProbability[position] = 1.0f;
+			break;
+		}
+		}
+	}
+
+	// Picks a parent using the selected method. pickNumber is which parent this is for the generation (0, 1, 2...)
+	const NetworkWeightFitness* pickParent(const std::vector< NetworkWeightFitness >& parents, const float totalFitness, const size_t pickNumber, RandomStream& random) const {
+		switch (m_selection) {
+		case SelectionMethod::smPrefixSum: {
+			const float randValue = random.nextFloat() * totalFitness;
+			// The first parent whose running total reaches the random value
+			const std::vector<float>::const_iterator found = std::lower_bound(m_runningTotal.begin(), m_runningTotal.end(), randValue);
+			if (found == m_runningTotal.end()) return &parents[parents.size() - 1];
+			return &parents[found - m_runningTotal.begin()];
+		}
+
+		case SelectionMethod::smAlias: {
+			const double position = random.nextDouble() * parents.size();
+			const size_t slot = (size_t)position;
+			return &parents[((float)(position - slot) < m_aliasProbability[slot]) ? slot : m_alias[slot]];
+		}
+
+		case SelectionMethod::smStochasticUniversal:
+			if (pickNumber < m_sampled.size()) return &parents[m_sampled[pickNumber]];
+			return pickParentByRoulette(parents, totalFitness, random);
+
+		default:
+			return pickParentByRoulette(parents, totalFitness, random);
 		}
 	}
 
+	// Mutate the supplied weights
+	void mutateWeights(const GenomeView& weights, RandomStream& random) const {
+		for (float& weight : weights)
+			if (random.nextFloat() < m_mutationRate) // Should we mutate?
+				weight += m_mutationAmount * ((random.nextFloat() * 2.0f) - 1.0f);
+	}
+
+	// Create a child from the supplied parents. Both parts of each child are straight block copies
+	void reproduce(const ConstGenomeView& parent1Weights, const ConstGenomeView& parent2Weights, const GenomeView& child1Weights, const GenomeView& child2Weights, RandomStream& random) const {
+		const size_t size = parent1Weights.size();
+		const size_t point = random.nextIndex(size + 1);
+		memcpy(child1Weights.data(), parent1Weights.data(), point * sizeof(float));
+		memcpy(child2Weights.data(), parent2Weights.data(), point * sizeof(float));
+		memcpy(child1Weights.data() + point, parent2Weights.data() + point, (size - point) * sizeof(float));
+		memcpy(child2Weights.data() + point, parent1Weights.data() + point, (size - point) * sizeof(float));
+	}
+
 public:
 	// Create the genetic algorithm mutation class
-	GeneticAlgorithm(const size_t numBest = 1, const float crossOverRate = 0.7f, const float mutationRate = 0.1f, const float mutationAmount = 0.3f)
-		: m_numBest(numBest), m_crossOverRate(crossOverRate), m_mutationRate(mutationRate), m_mutationAmount(mutationAmount) {
-		m_mutationRateForRandom = (int)(m_mutationRate * (float)RAND_MAX);
+	GeneticAlgorithm(const size_t numBest = 1, const float crossOverRate = 0.7f, const float mutationRate = 0.1f, const float mutationAmount = 0.3f, const SelectionMethod selection = SelectionMethod::smPrefixSum)
+		: m_numBest(numBest), m_crossOverRate(crossOverRate), m_mutationRate(mutationRate), m_mutationAmount(mutationAmount), m_selection(selection) {
+	}
+
+	// Set the run seed.  Each pair of children gets its own random stream made from this, the generation and the pair number,
+	// so the results don't depend on the order (or thread) they're made in
+	void setSeed(const uint64_t seed) {
+		m_seed = seed;
 	}
 
 	// Takes in the weights and fitness for the current generation, and produces the next one
-	void produceNextGeneration(std::vector< NetworkWeightFitness >& generation) const {
-		// For the next generation we only need to know their 'brain' - eg the neuron weights
-		std::vector<std::vector<float>> nextGeneration;
+	void produceNextGeneration(std::vector< NetworkWeightFitness >& generation) {
+		if (generation.empty()) return;
+
+		// For the next generation we only need to know their 'brain' - eg the neuron weights.
+		// The first time through the networks are moved into the pool, after that they already live there
+		const size_t genomeSize = generation[0].network->numWeights();
+		if (!m_pool.matches(generation.size(), genomeSize)) {
+			m_pool.resize(generation.size(), genomeSize);
+			for (size_t network = 0; network < generation.size(); network++) {
+				memcpy(m_pool.current(network).data(), generation[network].network->genome().data(), genomeSize * sizeof(float));
+				generation[network].network->useWeightStorage(m_pool.current(network).data());
+			}
+		}
+		size_t nextGenerationSize = 0;
+		auto child = [this](size_t index) -> GenomeView {
+			return m_pool.next(index);
+		};
 
 		// Step 1: Calculate the total fitness of the entire previous generation
 		float totalFitness = 0;
@@ -87,42 +256,40 @@ public:
 			return a.fitness < b.fitness;
 		});
 
-		// Step 3: Output the ones that were best on the previous generation
-		for (size_t count = 1; count <= m_numBest; count++) {
-			std::vector<float> weights;
-			generation[generation.size() - count].network->getWeights(weights);
-			nextGeneration.push_back(weights);
+		// Step 3: Output the ones that were best on the previous generation.  A population smaller than that is all kept
+		const size_t numBest = std::min(m_numBest, generation.size());
+		for (size_t count = 1; count <= numBest; count++) {
+			const ConstGenomeView weights = generation[generation.size() - count].network->genome();
+			memcpy(child(nextGenerationSize++).data(), weights.data(), genomeSize * sizeof(float));
 		}
 
-		// Step 4: Now we produce the remainder of the new generation by mutating the existing one
-		while (nextGeneration.size() < generation.size()) {
-			// First, pick two semi-random parents from which to create a child
-			const NetworkWeightFitness* parent1 = pickParentByRoulette(generation, totalFitness);
-			const NetworkWeightFitness* parent2 = pickParentByRoulette(generation, totalFitness);
+		// Step 4: Now we produce the remainder of the new generation by mutating the existing one.  Two parents per pair of children
+		const size_t numChildren = (generation.size() > nextGenerationSize) ? generation.size() - nextGenerationSize : 0;
+		prepareSelection(generation, totalFitness, ((numChildren + 1) / 2) * 2);
 
-			// Produce a child by mixing the weights of the parents at a specific point
-			std::vector<float> parent1Weights;
-			std::vector<float> parent2Weights;
-			std::vector<float> child1Weights, child2Weights;
+		for (size_t pair = 0; nextGenerationSize < generation.size(); pair++) {
+			RandomStream random(m_seed, RandomPurpose::rpGenome, pair, m_generation);
 
-			// Extract the 'genome'/'dna' weights from the parents
-			parent1->network->getWeights(parent1Weights);
-			parent2->network->getWeights(parent2Weights);
+			// First, pick two semi-random parents from which to create a child
+			const NetworkWeightFitness* parent1 = pickParent(generation, totalFitness, pair * 2, random);
+			const NetworkWeightFitness* parent2 = pickParent(generation, totalFitness, (pair * 2) + 1, random);
 
-			// Mix up.  This is a simple cross-over function. There are more complex ways to do this
-			reproduce(parent1Weights, parent2Weights, child1Weights, child2Weights);
+			// The children are written straight into the next generation
+			const GenomeView child1Weights = child(nextGenerationSize++);
+			const GenomeView child2Weights = child(nextGenerationSize++);
 
-			// And now mutate the child
-			mutateWeights(child1Weights);
-			mutateWeights(child2Weights);
+			// Mix up the 'genome'/'dna' weights of the parents.  This is a simple cross-over function. There are more complex ways to do this
+			reproduce(parent1->network->genome(), parent2->network->genome(), child1Weights, child2Weights, random);
 
-			// It's the new generation
-			nextGeneration.push_back(child1Weights);
-			nextGeneration.push_back(child2Weights);
+			// And now mutate the child
+			mutateWeights(child1Weights, random);
+			mutateWeights(child2Weights, random);
 		}
 
-		// Step 5: Re-program the input with the new 'brains'
+		// Step 5: Re-program the input with the new 'brains'.  They just switch over to their new genome
 		for (size_t network = 0; network < generation.size(); network++)
-			generation[network].network->setWeights(nextGeneration[network]);
+			generation[network].network->useWeightStorage(child(network).data());
+		m_pool.swap();
+		m_generation++;
 	}
 };
\ No newline at end of file
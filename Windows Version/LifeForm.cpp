@@ -12,228 +12,239 @@
 #include "LifeForm.h"
 
 
-LifeForm::LifeForm(NeuralNetwork* brain, Simulation* simulation, int index) : m_brain(brain), m_simulation(simulation), m_index(index)  {
+template<class Mode>
+LifeForm<Mode>::LifeForm(NeuralNetwork* brain, Simulation<Mode>* simulation, int index) : m_brain(brain), m_simulation(simulation), m_population(&simulation->population()), m_index(index)  {
 	reset();
 }
 
+// Return the position of this lifeform
+template<class Mode>
+FloatPair LifeForm<Mode>::position() const {
+	return m_population->position(m_index);
+}
+
 // Reset the position, age and resources without affecting the brain
-void LifeForm::resetAge() {
-	m_angle = (float)((rand() * M_PI * 2.0f) / (float)RAND_MAX);
-	m_lastMovement.x = (float)cos(m_angle);
-	m_lastMovement.y = (float)sin(m_angle);
+template<class Mode>
+void LifeForm<Mode>::resetAge() {
+	m_random.reset(m_simulation->seed(), RandomPurpose::rpLifeform, m_index, m_simulation->generation());
+	const float angle = (float)(m_random.nextFloat() * M_PI * 2.0f);
 
 	// Choose a starting position where there are no resources under it
-	m_simulation->getRandomPosition(m_position);
-	m_lastPosition = m_position;
-	m_targetCell.target = m_position;
-#ifdef USE_SOLAR
-	m_targetSun.target = m_position;
-	m_resources.sun = SUN_USED_PER_STEP * INITIAL_STEPS;
-#endif
-#ifdef HAS_QUICKSAND
-	m_targetSand.target = m_position;
-#endif
-#ifdef TRACK_OTHERS
-	m_resourceIndex = -1;				
-	m_otherCompetitorFound = false;    
-	m_wasShieldActive = false;
-#endif
+	FloatPair position;
+	m_simulation->getRandomPosition(position, m_random);
+	m_population->place(m_index, position, angle);
+	m_targetCell.target = position;
+	if constexpr (Mode::useSolar) {
+		m_targetSun.target = position;
+		m_population->sun(m_index) = SUN_USED_PER_STEP * INITIAL_STEPS;
+	}
+	if constexpr (Mode::hasQuickSand) m_targetSand.target = position;
+	if constexpr (Mode::trackOthers) {
+		m_resourceIndex = -1;				
+		m_otherCompetitorFound = false;    
+		m_wasShieldActive = false;
+	}
 
-	m_lifeSpan = 0;
-	m_resources.cell = CELL_USED_PER_STEP * INITIAL_STEPS;
+	m_population->lifeSpan(m_index) = 0;
+	m_population->cell(m_index) = CELL_USED_PER_STEP * INITIAL_STEPS;
 }
 
 // Resets the lifeform back to totally random initial state
-void LifeForm::reset() {
+template<class Mode>
+void LifeForm<Mode>::reset() {
 	resetAge();
-	m_brain->randomize();
+	RandomStream random(m_simulation->seed(), RandomPurpose::rpBrain, m_index);
+	m_brain->randomize(random);
 }
 
 // Calculate a score on how well this lifeform did.
 // It is rewarded on its age, and then by available resources
-void LifeForm::calculateFitness() {
-#ifdef USE_SOLAR	
-#ifdef USE_MULTIPLY_FUNCTION
-	m_fitnessValue = (m_lifeSpan * 2.0f / GENERATION_LIFESPAN) + (((float)m_resources.sun / (float)MAX_SUN) * ((float)m_resources.cell / (float)MAX_CELL));
-#else
-	m_fitnessValue = (m_lifeSpan * 2.0f / GENERATION_LIFESPAN) + (((float)m_resources.sun / (float)MAX_SUN) + ((float)m_resources.cell / (float)MAX_CELL));
-#endif
-#else
-	m_fitnessValue = (m_lifeSpan * 2.0f / GENERATION_LIFESPAN) + ((float)m_resources.cell / (float)MAX_CELL);
-#endif
+template<class Mode>
+void LifeForm<Mode>::calculateFitness() {
+	const unsigned int lifeSpan = m_population->lifeSpan(m_index);
+	const int cell = m_population->cell(m_index);
+	if constexpr (Mode::useSolar) {
+		const int sun = m_population->sun(m_index);
+		if constexpr (Mode::multiplyFitness)
+			m_fitnessValue = (lifeSpan * 2.0f / GENERATION_LIFESPAN) + (((float)sun / (float)MAX_SUN) * ((float)cell / (float)MAX_CELL));
+		else
+			m_fitnessValue = (lifeSpan * 2.0f / GENERATION_LIFESPAN) + (((float)sun / (float)MAX_SUN) + ((float)cell / (float)MAX_CELL));
+	}
+	else m_fitnessValue = (lifeSpan * 2.0f / GENERATION_LIFESPAN) + ((float)cell / (float)MAX_CELL);
 }
 
 // Return the current fitness value
-float LifeForm::getFitness() {
+template<class Mode>
+float LifeForm<Mode>::getFitness() {
 	return m_fitnessValue < 0 ? 0 : m_fitnessValue;
 }
 
 // Run the lifeform 1 entire iteration.  Returns TRUE if the lifeform is still living
-bool LifeForm::step() {
+template<class Mode>
+bool LifeForm<Mode>::step() {
 	// Stop of they're 'dead'
-	if (!isAlive()) return false;
+	if (!sense()) return false;
 
-	// Track usage
-#ifdef USE_SOLAR
-	m_resources.sun -= SUN_USED_PER_STEP;
-#endif
-	m_resources.cell -= CELL_USED_PER_STEP;
-	m_lifeSpan++;
+	// Make the brain update
+	m_brain->update();
+
+	return act();
+}
 
+// Gather the inputs for the brain.  Returns FALSE if the lifeform is dead
+template<class Mode>
+bool LifeForm<Mode>::sense() {
+	// Track usage.  Stop of they're 'dead'
+	m_population->drain(m_index, m_index + 1);
+	if (!m_population->isActive(m_index)) return false;
+
+	look();
+	return true;
+}
+
+// Gather the inputs for the brain, once the resources for this step have been used up
+template<class Mode>
+void LifeForm<Mode>::look() {
 	// Get some basic input from the simulation about available resources
-	m_lastPosition = m_position;
-	m_simulation->findDirectionToResources(m_lastPosition, m_targetCell
-#ifdef USE_SOLAR 
-		, m_targetSun
-#endif	
-#ifdef HAS_QUICKSAND 
-		, m_targetSand
-#endif	
-#ifdef TRACK_OTHERS
-		, m_resourceIndex
-		, m_index
-#endif
-	);
+	const FloatPair lastPosition = m_population->lastPosition(m_index);
+	const FloatPair lastMovement = m_population->lastMovement(m_index);
+	const int cell = m_population->cell(m_index);
+	m_simulation->findDirectionToResources(lastPosition, m_targetCell, m_targetSun, m_targetSand, m_resourceIndex, m_index);
 
 	// Pass in the direction we actually moved last time
-	m_brain->setInput(0, m_lastMovement.x);
-	m_brain->setInput(1, m_lastMovement.y);
+	m_brain->setInput(0, lastMovement.x);
+	m_brain->setInput(1, lastMovement.y);
 
 	// Update the 'brain' with this information.  The Directions are basically normalised vector directions
 	m_brain->setInput(2, m_targetCell.direction.x);
 	m_brain->setInput(3, m_targetCell.direction.y);
 
 	// Pass in details about what resources it has left
-	m_brain->setInput(4, (float)m_resources.cell / (float)MAX_CELL);
-
-#ifdef USE_SOLAR
-	m_brain->setInput(5, m_targetSun.direction.x);
-	m_brain->setInput(6, m_targetSun.direction.y);
-	float sun = ((float)m_resources.sun / (float)MAX_SUN)/2;
-	float battery = ((float)m_resources.cell / (float)MAX_CELL)/2;
-	if (sun>battery)
-		m_brain->setInput(4, 0.5f + sun); else m_brain->setInput(4, 0.5f - battery);
-	
-#else
-#ifdef HAS_QUICKSAND
-	m_brain->setInput(5, m_targetSand.direction.x);
-	m_brain->setInput(6, m_targetSand.direction.y);
-	m_brain->setInput(7, m_quickSandUnderLifeform ? 1.0f : 0.0f);
-#else
-#ifdef TRACK_OTHERS
-	// Get the direction to the person also after the same resource as us
-	m_brain->setInput(5, m_simulation->isResourceTargettedByAnother(this, m_resourceIndex) ? 1.0f : 0.0f);
-	m_brain->setInput(6, m_wasShieldActive ? 1.0f : 0.0f);
-#endif
-#endif
-#endif
-
-	// Make the brain update
-	m_brain->update();
-
-	// Take the outputs and update our position.  The two outputs represent the speed of the left and right 'feet' 
-	float angleChange = m_brain->value(1) - m_brain->value(0);
-	if (angleChange < -MAX_TURN_SPEED) angleChange = -MAX_TURN_SPEED;
-	if (angleChange > MAX_TURN_SPEED) angleChange = MAX_TURN_SPEED;
+	m_brain->setInput(4, (float)cell / (float)MAX_CELL);
+
+	if constexpr (Mode::useSolar) {
+		m_brain->setInput(5, m_targetSun.direction.x);
+		m_brain->setInput(6, m_targetSun.direction.y);
+		float sun = ((float)m_population->sun(m_index) / (float)MAX_SUN)/2;
+		float battery = ((float)cell / (float)MAX_CELL)/2;
+		if (sun>battery)
+			m_brain->setInput(4, 0.5f + sun); else m_brain->setInput(4, 0.5f - battery);
+	}
+	else if constexpr (Mode::hasQuickSand) {
+		m_brain->setInput(5, m_targetSand.direction.x);
+		m_brain->setInput(6, m_targetSand.direction.y);
+		m_brain->setInput(7, m_population->quickSand(m_index) ? 1.0f : 0.0f);
+	}
+	else if constexpr (Mode::trackOthers) {
+		// Get the direction to the person also after the same resource as us
+		m_otherCompetitorFound = m_simulation->findCompetitor(m_index, lastPosition, m_resourceIndex, m_otherCompetitor);
+		m_brain->setInput(5, m_simulation->isResourceTargettedByAnother(m_index, m_resourceIndex) ? 1.0f : 0.0f);
+		m_brain->setInput(6, m_wasShieldActive ? 1.0f : 0.0f);
+		m_brain->setInput(7, m_otherCompetitor.direction.x);
+		m_brain->setInput(8, m_otherCompetitor.direction.y);
+	}
+}
 
-	// Update the angle we're facing
-	m_angle += angleChange;
-	float speedStep = m_brain->value(1) + m_brain->value(0);
+// Apply the outputs from the brain.  Returns TRUE if the lifeform is still living
+template<class Mode>
+bool LifeForm<Mode>::act() {
+	if constexpr (Mode::trackOthers) useShield();
+	m_population->setOutputs(m_index, m_brain->value(0), m_brain->value(1));
+	m_population->move(m_index, m_index + 1);
 
-	m_lastMovement.x = (float)cos(m_angle);
-	m_lastMovement.y = (float)sin(m_angle);
+	// Check the new position for resources.  The last parameter says we want to 'consume' it
+	return land(m_simulation->resourceTypeAtPosition(position(), true, -1, m_index));
+}
 
-#ifdef TRACK_OTHERS
+// Raise or lower the shield using the outputs from the brain (MODE4)
+template<class Mode>
+void LifeForm<Mode>::useShield() {
 	m_wasShieldActive = false;
-	if ((m_brain->value(2) > m_brain->value(3)) && (m_resources.cell > (float)(MAX_CELL/3))) {
+	if ((m_brain->value(2) > m_brain->value(3)) && (m_population->cell(m_index) > (float)(MAX_CELL/3))) {
 		// Shield reduces power faster
 		if (m_simulation->shieldResource(m_resourceIndex, m_index)) {
-			m_resources.cell -= 2;
+			m_population->cell(m_index) -= 2;
 		}
 		m_wasShieldActive = true;
 	}
 	else m_simulation->releaseShield(m_index);
-#endif
-
-#ifdef HAS_QUICKSAND
-	// It slows us down
-	if (m_quickSandUnderLifeform) speedStep *= 0.25;
-#endif
-
-	m_position.x += m_lastMovement.x * speedStep;
-	m_position.y += m_lastMovement.y * speedStep;
-
-	// The world wraps, if we go off an edge we appear on the opposite side
-	m_simulation->wrapCoordinates(m_position);
+}
 
-#ifdef HAS_QUICKSAND
-	m_quickSandUnderLifeform = false;
-#endif
-
-	// Check the new position for resources.  The last parameter says we want to 'consume' it
-	switch (m_simulation->resourceTypeAtPosition(m_position, true, -1, m_index)) {
+// Collect the resource found where we moved to.  Returns TRUE if the lifeform is still living
+template<class Mode>
+bool LifeForm<Mode>::land(const ResourceType found) {
+	switch (found) {
 
 		// Did we land on oil?
-		case ResourceType::rtCell:
-			m_resources.cell += CELL_GAINED_WHEN_EATEN;
-			if (m_resources.cell > MAX_CELL) m_resources.cell = MAX_CELL;
+		case ResourceType::rtCell: {
+			int& cell = m_population->cell(m_index);
+			cell += CELL_GAINED_WHEN_EATEN;
+			if (cell > MAX_CELL) cell = MAX_CELL;
 			break;
+		}
 
-#ifdef HAS_QUICKSAND
 		case ResourceType::rtQuickSand:
-			m_quickSandUnderLifeform = true;
+			if constexpr (Mode::hasQuickSand) m_population->quickSand(m_index) = 1;
 			break;
-#endif
 
-#ifdef USE_SOLAR
 		// How about sunlight?
 		case ResourceType::rtSunlight:
-			m_resources.sun += SUN_GAINED_WHEN_DRANK;
-			if (m_resources.sun > MAX_SUN) m_resources.sun = MAX_SUN;
+			if constexpr (Mode::useSolar) {
+				int& sun = m_population->sun(m_index);
+				sun += SUN_GAINED_WHEN_DRANK;
+				if (sun > MAX_SUN) sun = MAX_SUN;
+			}
+			break;
+
+		default:
 			break;
-#endif
 	}
 
-#ifdef TRACK_OTHERS
-	if (!isAlive()) {
-		m_simulation->releaseShield(m_index);
-		return false;
+	if constexpr (Mode::trackOthers) {
+		if (!isAlive()) {
+			m_simulation->releaseShield(m_index);
+			return false;
+		}
 	}
-#endif
 
 
 	return true;
 }
 
 // Returns TRUE if the lifeform is still alive
-bool LifeForm::isAlive() {
-	return (m_resources.cell > 0) 
-#ifdef USE_SOLAR
-		   && (m_resources.sun > 0)
-#endif		
-		;
+template<class Mode>
+bool LifeForm<Mode>::isAlive() {
+	return m_population->isAlive(m_index);
 }
 
 // Capture some data about the lifeform for drawing to the screen
-void LifeForm::getDrawDetails(LifeformStatus& status) {
-	status.positionX = (int)m_lastPosition.x;
-	status.positionY = (int)m_lastPosition.y;
-	status.angleFacing = m_angle;
+template<class Mode>
+void LifeForm<Mode>::getDrawDetails(LifeformStatus& status) {
+	const FloatPair lastPosition = m_population->lastPosition(m_index);
+	status.positionX = (int)lastPosition.x;
+	status.positionY = (int)lastPosition.y;
+	status.angleFacing = m_population->angle(m_index);
 	status.alive = isAlive();
-	status.resources = m_resources;
-#ifdef USE_SOLAR
-	status.sunTarget = m_targetSun.target;
-	status.sunTargetAvailable = m_targetSun.available;
-#endif
-#ifdef HAS_QUICKSAND
-	status.sandTarget = m_targetSand.target;
-	status.sandTargetAvailable = m_targetSand.available;
-#endif
-#ifdef TRACK_OTHERS
-	status.otherCompetitorFound = m_otherCompetitorFound;
-	status.otherCompetitor = m_otherCompetitor.target;
-	ResourceTarget otherCompetitor;
-#endif
+	status.resources.cell = m_population->cell(m_index);
+	if constexpr (Mode::useSolar) {
+		status.resources.sun = m_population->sun(m_index);
+		status.sunTarget = m_targetSun.target;
+		status.sunTargetAvailable = m_targetSun.available;
+	}
+	if constexpr (Mode::hasQuickSand) {
+		status.sandTarget = m_targetSand.target;
+		status.sandTargetAvailable = m_targetSand.available;
+	}
+	if constexpr (Mode::trackOthers) {
+		status.otherCompetitorFound = m_otherCompetitorFound;
+		status.otherCompetitor = m_otherCompetitor.target;
+	}
 	status.cellTarget = m_targetCell.target;
 	status.cellTargetAvailable = m_targetCell.available;
 }
+
+// Build the lifeforms for each of the experiments
+template class LifeForm<ExperimentMode<MODE1>>;
+template class LifeForm<ExperimentMode<MODE2>>;
+template class LifeForm<ExperimentMode<MODE3>>;
+template class LifeForm<ExperimentMode<MODE4>>;
@@ -9,8 +9,10 @@
 
 #pragma once
 
+#include "Random.h"
 
 enum class ResourceType { rtNone, rtCell, rtSunlight, rtQuickSand };
+#define NUM_RESOURCE_TYPES		4
 
 // Struct to hold two floats
 struct FloatPair {
@@ -19,9 +21,7 @@ struct FloatPair {
 };
 
 struct Resources {
-#ifdef USE_SOLAR
 	int sun = 0;
-#endif
 	int cell = 0;
 };
 
@@ -32,7 +32,7 @@ struct ResourceTarget {
 	bool available;
 };
 
-// Information used when displaying it
+// Information used when displaying it.  Only the parts the experiment uses are filled in
 struct LifeformStatus {
 	// Position and direction of the lifeform
 	int positionX, positionY;
@@ -41,75 +41,63 @@ struct LifeformStatus {
 	// Available resources 
 	Resources resources;
 
-#ifdef USE_SOLAR
 	FloatPair sunTarget;
-	bool sunTargetAvailable;
-#endif
+	bool sunTargetAvailable = false;
 
 	FloatPair cellTarget;
-	bool cellTargetAvailable;
+	bool cellTargetAvailable = false;
 
-#ifdef HAS_QUICKSAND
 	FloatPair sandTarget;
-	bool sandTargetAvailable;
-#endif
+	bool sandTargetAvailable = false;
 
-#ifdef TRACK_OTHERS
-	bool otherCompetitorFound;
+	bool otherCompetitorFound = false;
 	FloatPair otherCompetitor;
-#endif
 
 	// Status!
 	bool alive;
 };
 
 // We'll define these elsewhere!
-class Simulation;
+template<class Mode> class Simulation;
+template<class Mode> class Population;
 class NeuralNetwork;
 
-// Main lifeform class
+// Main lifeform class.  Mode is the experiment it's taking part in, see ExperimentMode.h
+template<class Mode>
 class LifeForm {
 private:
-	Simulation* m_simulation;				// The simulation this is part of
+	Simulation<Mode>* m_simulation;			// The simulation this is part of
+	Population<Mode>* m_population;			// Where our position, angle, age and resources are kept
 	NeuralNetwork* m_brain;					// Neural Network brain
 
-	FloatPair m_position;					// Current position
-	FloatPair m_lastPosition;				// Last position
-	FloatPair m_lastMovement;				// Last movement
-	float m_angle = 0;						// Current angle
-	int m_index;							// Our index
+	int m_index;							// Our index (in the simulation and the population)
 	
-	unsigned int m_lifeSpan = 0;			// How long this has been alive for in 'iterations'
+	RandomStream m_random;					// Our own random numbers, re-seeded each generation
 
 	float m_fitnessValue = 0;				// Last calculated fitness value
 
-	Resources m_resources;					// What resources they have
-
-#ifdef USE_SOLAR
 	ResourceTarget m_targetSun;				// Where the sun is thats closest
-#endif
-#ifdef HAS_QUICKSAND
 	ResourceTarget m_targetSand;			// Where the quicksand is
-	bool m_quickSandUnderLifeform = false;  // Is there quicksand under us
-#endif
-#ifdef TRACK_OTHERS
+
+	// Shields (MODE4)
 	int m_resourceIndex = -1;				// Index of the resource that's nearest
 	bool m_otherCompetitorFound = false;    // If another competitor is valid
 	bool m_wasShieldActive = false;
 	ResourceTarget m_otherCompetitor;
-#endif
+
 	ResourceTarget m_targetCell;			// Where the cell is thats closest
 
 public:
-	LifeForm(NeuralNetwork* brain, Simulation* simulation, int index);
+	LifeForm(NeuralNetwork* brain, Simulation<Mode>* simulation, int index);
 
-#ifdef TRACK_OTHERS
-	// Returns TRUE where this resource is being targetted by this lifeform
+	// Returns TRUE where this resource is being targetted by this lifeform (MODE4)
 	bool isTargetingResource(const int index) { return index == m_resourceIndex; };
-#endif
+
+	// Returns the index of the resource this lifeform is heading for, or -1 (MODE4)
+	int targetResource() const { return m_resourceIndex; };
 
 	// Return the position of this lifeform
-	const FloatPair& position() { return m_position; };
+	FloatPair position() const;
 
 	// Reset the position, age and resources without affecting the brain
 	void resetAge();
@@ -127,6 +115,24 @@ public:
 	// Run the lifeform 1 entire iteration.  Returns TRUE if the lifeform is still living
 	bool step();
 
+	// The same iteration split in two so the brains can be updated in one batch between them.
+	// sense() feeds the brain its inputs and returns FALSE if the lifeform is dead (so the brain can be skipped)
+	bool sense();
+
+	// act() applies the outputs of the brain.  Returns TRUE if the lifeform is still living
+	bool act();
+
+	// The parts of sense() and act() that aren't done by the Population passes, so the simulation can use up resources
+	// and move a whole range of lifeforms at once.  look() is sense() after Population::drain().  act() is useShield(),
+	// Population::move(), then land() with whatever is at the new position
+	void look();
+	void useShield();
+	// Returns TRUE if the lifeform is still living
+	bool land(const ResourceType found);
+
+	// Return the brain controlling this lifeform
+	NeuralNetwork* brain() { return m_brain; };
+
 	// Capture some data about the lifeform for drawing to the screen
 	void getDrawDetails(LifeformStatus& status);
 
@@ -0,0 +1,167 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+// Uniform grid of points over a world that wraps at the edges, for things that all move every step (the lifeforms).
+// Rather than moving each point between cells it's rebuilt from scratch: the points are added, then sorted by cell with a
+// counting sort so each cell's points sit together in one array.  Cells are visited in rings around a point the same as
+// SpatialGrid, and distances take the shortest way round the world
+class NeighbourGrid {
+private:
+	struct Point {
+		float x, y;
+		int item;
+		int cell;
+	};
+
+	float m_width, m_height;
+	int m_columns, m_rows;
+	float m_cellWidth, m_cellHeight;
+	std::vector<Point> m_added;					// Points added since clear(), in the order they were added
+	std::vector<Point> m_points;				// The same points sorted by cell
+	std::vector<int> m_cellStart;				// Where each cell's points start in m_points, with the end on the end
+	std::vector<int> m_fill;
+
+	// Cell index containing a point, wrapping if its off the edge
+	int cellAt(const float x, const float y) const {
+		int column = (int)(x / m_cellWidth) % m_columns;
+		int row = (int)(y / m_cellHeight) % m_rows;
+		if (column < 0) column += m_columns;
+		if (row < 0) row += m_rows;
+		return (row * m_columns) + column;
+	}
+
+	// Call onPoint for everything in the cell offset (dx, dy) from (column, row)
+	template<typename F>
+	void visitCell(const int column, const int row, const int dx, const int dy, F& onPoint) const {
+		const int x = (column + dx + m_columns) % m_columns;
+		const int y = (row + dy + m_rows) % m_rows;
+		const int cell = (y * m_columns) + x;
+		for (int point = m_cellStart[cell]; point < m_cellStart[cell + 1]; point++) onPoint(m_points[point]);
+	}
+
+	// Call onPoint(point) for every point in ring 'ring' around (x, y)
+	template<typename F>
+	void forEachInRing(const float x, const float y, const int ring, F& onPoint) const {
+		const int cell = cellAt(x, y);
+		const int column = cell % m_columns;
+		const int row = cell / m_columns;
+
+		// The offsets that reach each column/row once going the shortest way round
+		const int lowX = -((m_columns - 1) / 2), highX = m_columns / 2;
+		const int lowY = -((m_rows - 1) / 2), highY = m_rows / 2;
+		const int firstX = -ring < lowX ? lowX : -ring, lastX = ring > highX ? highX : ring;
+		const int firstY = -ring < lowY ? lowY : -ring, lastY = ring > highY ? highY : ring;
+
+		for (int dy = firstY; dy <= lastY; dy++) {
+			if ((dy == -ring) || (dy == ring)) {
+				// Top and bottom edges of the ring
+				for (int dx = firstX; dx <= lastX; dx++) visitCell(column, row, dx, dy, onPoint);
+			}
+			else {
+				// Just the left and right sides
+				if (-ring >= lowX) visitCell(column, row, -ring, dy, onPoint);
+				if ((ring <= highX) && (ring != 0)) visitCell(column, row, ring, dy, onPoint);
+			}
+		}
+	}
+
+	// Number of rings needed to cover the whole world
+	int numRings() const {
+		return (m_columns > m_rows ? m_columns : m_rows) / 2 + 1;
+	}
+
+public:
+	// Cells are cellSize or a bit more, as with SpatialGrid, so the world is a whole number of them each way
+	NeighbourGrid(const int width, const int height, const int cellSize) : m_width((float)width), m_height((float)height) {
+		m_columns = width / cellSize;
+		m_rows = height / cellSize;
+		if (m_columns < 1) m_columns = 1;
+		if (m_rows < 1) m_rows = 1;
+		m_cellWidth = (float)width / (float)m_columns;
+		m_cellHeight = (float)height / (float)m_rows;
+		m_cellStart.resize(((size_t)m_columns * (size_t)m_rows) + 1, 0);
+	}
+
+	// Squared distance between two points, the shortest way round the world
+	float distanceSquared(const float x1, const float y1, const float x2, const float y2) const {
+		float distanceX = x1 < x2 ? x2 - x1 : x1 - x2;
+		float distanceY = y1 < y2 ? y2 - y1 : y1 - y2;
+		if (distanceX > m_width * 0.5f) distanceX = m_width - distanceX;
+		if (distanceY > m_height * 0.5f) distanceY = m_height - distanceY;
+		return (distanceX * distanceX) + (distanceY * distanceY);
+	}
+
+	// Start again with no points
+	void clear() {
+		m_added.clear();
+	}
+
+	// Add a point.  Nothing can be found until build() is called
+	void add(const int item, const float x, const float y) {
+		m_added.push_back({ x, y, item, cellAt(x, y) });
+	}
+
+	// Sort the points added into their cells.  Points in the same cell stay in the order they were added
+	void build() {
+		std::fill(m_cellStart.begin(), m_cellStart.end(), 0);
+		for (const Point& point : m_added) m_cellStart[point.cell + 1]++;
+		for (size_t cell = 1; cell < m_cellStart.size(); cell++) m_cellStart[cell] += m_cellStart[cell - 1];
+		m_fill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+		m_points.resize(m_added.size());
+		for (const Point& point : m_added) m_points[m_fill[point.cell]++] = point;
+	}
+
+	// Call onItem(item, distanceSquared) for every point within radius of (x, y)
+	template<typename F>
+	void forEachWithin(const float x, const float y, const float radius, F onItem) const {
+		const float cellSize = m_cellWidth < m_cellHeight ? m_cellWidth : m_cellHeight;
+		const float radiusSquared = radius * radius;
+		auto check = [&](const Point& point) {
+			const float distance = distanceSquared(x, y, point.x, point.y);
+			if (distance <= radiusSquared) onItem(point.item, distance);
+		};
+
+		// Everything in ring n is at least (n-1) cells away
+		const int rings = numRings();
+		for (int ring = 0; (ring < rings) && ((ring - 1) * cellSize <= radius); ring++) forEachInRing(x, y, ring, check);
+	}
+
+	// Find the nearest point to (x, y), no further away than maxDistance, where accept(item) is TRUE, and where it is.
+	// On a tie the lowest item wins.  Returns the item or -1 if there isn't one
+	template<typename F>
+	int nearest(const float x, const float y, const float maxDistance, F accept, float& foundX, float& foundY) const {
+		int found = -1;
+		float foundDistance = maxDistance * maxDistance;
+		auto check = [&](const Point& point) {
+			const float distance = distanceSquared(x, y, point.x, point.y);
+			if ((distance > foundDistance) || ((found >= 0) && (distance == foundDistance) && (point.item > found))) return;
+			if (accept(point.item)) {
+				found = point.item;
+				foundDistance = distance;
+				foundX = point.x;
+				foundY = point.y;
+			}
+		};
+
+		// Work outwards ring by ring until nothing further out could be nearer.  Everything in ring n is at least (n-1) cells away
+		const float cellSize = m_cellWidth < m_cellHeight ? m_cellWidth : m_cellHeight;
+		const int rings = numRings();
+		for (int ring = 0; ring < rings; ring++) {
+			const float reach = (ring - 1) * cellSize;
+			if ((reach > 0) && (foundDistance < reach * reach)) break;
+			forEachInRing(x, y, ring, check);
+		}
+		return found;
+	}
+};
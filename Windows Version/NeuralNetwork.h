@@ -13,104 +13,66 @@
 #include <cmath>
 #include <math.h>
 #include <stdlib.h> 
+#include <string.h>
 #include <vector>
-
-// A simple abstract class defining that "value" output must exist
-class AbstractNeuronOutput {
-public:
-	virtual float value() abstract;
-};
-
-// A simple input neuron - does nothing.
-class InputNeuron : public AbstractNeuronOutput {
+#include <algorithm>
+#include "SimdKernels.h"
+#include "Activation.h"
+#include "Random.h"
+
+// A view onto weights that live somewhere else, so genomes can be read and written in place (like std::span)
+template<typename T>
+class WeightSpan {
 private:
-	float m_value = 0;
+	T* m_data = nullptr;
+	size_t m_size = 0;
 public:
-	// Get value
-	virtual float value() override { 
-		return m_value; 
-	};
-
-	// Set value
-	void setValue(const float value) { 
-		m_value = value; 
-	};
+	WeightSpan() {}
+	WeightSpan(T* data, size_t size) : m_data(data), m_size(size) {}
+
+	// Allow a writable span to be used where a read-only one is wanted
+	template<typename U>
+	WeightSpan(const WeightSpan<U>& other) : m_data(other.data()), m_size(other.size()) {}
+
+	T* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	T* begin() const { return m_data; }
+	T* end() const { return m_data + m_size; }
+	T& operator[](size_t index) const { return m_data[index]; }
 };
+typedef WeightSpan<float> GenomeView;
+typedef WeightSpan<const float> ConstGenomeView;
 
-// Normal neuron
-class Neuron : public AbstractNeuronOutput {
+// Simple neural network with no feedback.
+// Each layer is stored as a single row-major weight matrix, one row per neuron, and all of the
+// neuron values live in one activation buffer so update() is just a set of tight loops.
+class NeuralNetwork {
 private:
-	// Neuron weight list
-	struct NeuronWeight {
-		AbstractNeuronOutput* neuron = nullptr;
-		float weight = 1;
+	// Where a layer lives within the weight and value buffers
+	struct Layer {
+		size_t inputs;			// Number of neurons feeding into this layer
+		size_t outputs;			// Number of neurons in this layer
+		size_t weightOffset;	// Start of this layers weight matrix in the weights
+		size_t inputOffset;		// Start of the values feeding this layer in m_values
+		size_t outputOffset;	// Start of this layers output values in m_values
 	};
 
-	// Input neurons
-	std::vector<NeuronWeight> m_inputNeurons;
-
-	// Current output weight
-	float m_outputWeight = 1;
-
-	// The current cached output value of the neuron
-	float m_output = 0;
-public:
-	Neuron(const std::vector<AbstractNeuronOutput*> inputNeurons) {
-		// Build up the neuron list
-		for (AbstractNeuronOutput* neuron : inputNeurons)
-			m_inputNeurons.push_back({ neuron, 1 });
-	}
-
-	// Sigmoid activation function
-	static float Sigmoid(float input) {
-		return 1.0f / (1.0f + (float)pow(M_E, -input));
-	}
-
-	// Get value
-	virtual float value() override {
-		return m_output;
-	}
-
-	// Update the neuron with the latest value
-	void update() {
-		m_output = 0;
-		for (const NeuronWeight& neuronWeight : m_inputNeurons)
-			m_output += neuronWeight.weight * neuronWeight.neuron->value();
-		m_output = Neuron::Sigmoid(m_output);
-	}
-
-	// Randomize all the weights in the neuron
-	void randomize() {
-		m_outputWeight = (float)rand() / (float)RAND_MAX;
-		for (NeuronWeight& neuronWeight : m_inputNeurons)
-			neuronWeight.weight = (float)rand() / (float)RAND_MAX;
-	}
+	// All the layers after the input layer
+	std::vector<Layer> m_layers;
 
-	// Adds to the supplied vector all the weights in this neuron
-	void getWeights(std::vector<float>& weights) const {
-		weights.push_back(m_outputWeight);
+	// Every weight in the network.  Each neuron is a row of (1 + inputs) floats, the output weight
+	// followed by one weight per input.  This is the same order as the genome, so getWeights/setWeights are straight copies
+	std::vector<float> m_weights;
 
-		for (const NeuronWeight& neuronWeight : m_inputNeurons)
-			weights.push_back(neuronWeight.weight);
-	}
+	// Where the weights actually are.  Normally m_weights, but they can be moved into shared storage (eg. a GenomePool)
+	float* m_genome;
+	size_t m_numWeights;
 
-	// Set the weights, position is the start and end position (on exit)
-	void setWeights(const std::vector<float> weights, size_t& position) {
-		m_outputWeight = weights[position++];
-		for (NeuronWeight& neuronWeight : m_inputNeurons)
-			neuronWeight.weight = weights[position++];
-	}
-};
+	// The value of every neuron, the input layer first followed by the output of each layer
+	std::vector<float> m_values;
 
-// Simple neural network with no feedback
-class NeuralNetwork {
-private:
-	// The input neuron layer
-	std::vector<InputNeuron*> m_inputNeurons;
-	// All the subsequent layers
-	std::vector<
-		std::vector<Neuron*>
-	> m_layers;
+	// The activation function applied to each neuron
+	ActivationFunction m_activation;
 
 public:
 	//  Rather than mess around, disable the copy methods
@@ -118,80 +80,151 @@ public:
 	NeuralNetwork& operator=(NeuralNetwork&) = delete;
 
 	// Create a network.  Vector contains the number of neurons in each layer
-	NeuralNetwork(std::vector<size_t> layerSizes) {
-		// Add the inputs
-		std::vector<AbstractNeuronOutput*> previousLayer;
-		while (m_inputNeurons.size() < layerSizes[0]) {
-			InputNeuron* neuron = new InputNeuron();
-			m_inputNeurons.push_back(neuron);
-			previousLayer.push_back(neuron);
-		}
-		
-		// Now populate
-		std::vector<AbstractNeuronOutput*> nextLayer;
+	NeuralNetwork(const std::vector<size_t>& layerSizes, const ActivationFunction activation = ActivationFunction::afSigmoid) : m_activation(activation) {
+		size_t numWeights = 0;
+		size_t numValues = layerSizes[0];
+
+		// Work out where everything will live
 		for (size_t layer = 1; layer < layerSizes.size(); layer++) {
-			nextLayer.clear();
-			std::vector<Neuron*> layerGenerated;
-
-			// Build up the layer
-			for (size_t count = 0; count < layerSizes[layer]; count++) {
-				Neuron* neuron = new Neuron(previousLayer);
-				layerGenerated.push_back(neuron);
-				nextLayer.push_back(neuron);
-			}
-
-			// Save
-			m_layers.push_back(layerGenerated);
-			previousLayer = nextLayer;
+			Layer l;
+			l.inputs = layerSizes[layer - 1];
+			l.outputs = layerSizes[layer];
+			l.weightOffset = numWeights;
+			l.inputOffset = numValues - l.inputs;
+			l.outputOffset = numValues;
+			m_layers.push_back(l);
+
+			numWeights += l.outputs * (l.inputs + 1);
+			numValues += l.outputs;
 		}
+
+		// Same defaults as before, all weights start at 1
+		m_weights.resize(numWeights, 1.0f);
+		m_genome = m_weights.data();
+		m_numWeights = numWeights;
+		m_values.resize(numValues, 0.0f);
+	}
+
+	// Sigmoid activation function
+	static float Sigmoid(float input) {
+		return SimdKernels::sigmoid(input);
+	}
+
+	// Change the activation function used by the neurons
+	void setActivation(const ActivationFunction activation) {
+		m_activation = activation;
 	}
 
-	// Free up memory
-	~NeuralNetwork() {
-		for (InputNeuron* neuron : m_inputNeurons) delete neuron;
-		for (std::vector<Neuron*>& layer : m_layers)
-			for (Neuron* neuron : layer)
-				delete neuron;
+	// Return the activation function used by the neurons
+	ActivationFunction activation() const {
+		return m_activation;
 	}
 
 	// Randomize all the weighting in the layer
-	void randomize() {
-		for (std::vector<Neuron*>& layer : m_layers)
-			for (Neuron* neuron : layer)
-				neuron->randomize();
+	void randomize(RandomStream& random) {
+		for (size_t weight = 0; weight < m_numWeights; weight++)
+			m_genome[weight] = random.nextFloat();
 	}
 
 	// Set an inputs value
 	void setInput(size_t inputNumber, const float value) {
-		m_inputNeurons[inputNumber]->setValue(value);
+		m_values[inputNumber] = value;
 	}
 
 	// Get all weights that make up this network
 	void getWeights(std::vector<float>& weights) const {
-		for (const std::vector<Neuron*>& layer : m_layers)
-			for (Neuron* neuron : layer)
-				neuron->getWeights(weights);
+		weights.insert(weights.end(), m_genome, m_genome + m_numWeights);
 	}
 
 	// Set all weights that make up this network.  Returns the weights used
 	size_t setWeights(const std::vector<float>& weights) {
-		size_t position = 0;
+		return setWeights(ConstGenomeView(weights.data(), weights.size()));
+	}
+
+	// Set all weights that make up this network from a genome stored elsewhere.  Returns the weights used
+	size_t setWeights(const ConstGenomeView& weights) {
+		memcpy(m_genome, weights.data(), m_numWeights * sizeof(float));
+		return m_numWeights;
+	}
+
+	// Number of weights (the size of the genome)
+	size_t numWeights() const {
+		return m_numWeights;
+	}
+
+	// Direct access to the weights (the genome) so they can be read and modified in place
+	GenomeView genome() {
+		return GenomeView(m_genome, m_numWeights);
+	}
+	ConstGenomeView genome() const {
+		return ConstGenomeView(m_genome, m_numWeights);
+	}
 
-		for (std::vector<Neuron*>& layer : m_layers)
-			for (Neuron* neuron : layer)
-				neuron->setWeights(weights, position);
-		return position;
+	// Use weights stored somewhere else rather than the networks own copy.  Nothing is copied, the storage must
+	// hold numWeights() floats and outlive the network (or until this is called again)
+	void useWeightStorage(float* weights) {
+		m_genome = weights;
+		// Our own copy is no longer needed
+		if (!m_weights.empty()) std::vector<float>().swap(m_weights);
 	}
 
 	// Get the output from a specific neuron
 	float value(size_t outputNeuron) const {
-		return m_layers.back().at(outputNeuron)->value();
+		return m_values[m_layers.back().outputOffset + outputNeuron];
+	}
+
+	// Calculates the output of a single layer (0 is the first layer after the inputs)
+	void updateLayer(size_t layerNumber) {
+		const Layer& layer = m_layers[layerNumber];
+		float* outputs = m_values.data() + layer.outputOffset;
+
+		// Each row starts with the output weight, the input weights follow it
+		SimdKernels::dotRows(m_genome + layer.weightOffset + 1, layer.inputs + 1, m_values.data() + layer.inputOffset, layer.inputs, outputs, layer.outputs);
+		Activation::apply(m_activation, outputs, layer.outputs);
 	}
 
 	// Calculates the latest output from the network
 	void update() {
-		for (std::vector<Neuron*>& layer : m_layers)
-			for (Neuron* neuron : layer)
-				neuron->update();		
+		for (size_t layer = 0; layer < m_layers.size(); layer++)
+			updateLayer(layer);
+	}
+
+	// Somewhere to work on a batch of networks in updateBatch().  Keep one per thread, it only allocates when the batch grows
+	struct Batch {
+		std::vector<const float*> weights;	// Where each network's weights for the layer being updated start
+		std::vector<float> values;			// The values of every network in the batch, laid out a layer at a time
+	};
+
+	// Calculates the latest output for a batch of networks that all share the same topology and activation function.
+	// Each layer is worked out for the whole batch at once: the inputs of every network sit side by side, one kernel
+	// call does every network's dot products and the activation function is applied to all of their outputs together.
+	// Each network gets exactly the same values as update() would give it
+	static void updateBatch(NeuralNetwork* const* networks, const size_t count, Batch& batch) {
+		if (count < 1) return;
+		const NeuralNetwork& first = *networks[0];
+		const size_t numInputs = first.m_layers[0].inputs;
+		const size_t numValues = first.m_values.size();
+		batch.weights.resize(count);
+		batch.values.resize(count * numValues);
+
+		// A layer at offset n in m_values is at (count * n) in the batch, so each layer's outputs are the next one's inputs
+		float* values = batch.values.data();
+		for (size_t network = 0; network < count; network++)
+			memcpy(values + (network * numInputs), networks[network]->m_values.data(), numInputs * sizeof(float));
+
+		for (const Layer& layer : first.m_layers) {
+			for (size_t network = 0; network < count; network++)
+				batch.weights[network] = networks[network]->m_genome + layer.weightOffset + 1;
+			float* outputs = values + (count * layer.outputOffset);
+			SimdKernels::dotRowsBatch(batch.weights.data(), layer.inputs + 1, values + (count * layer.inputOffset), layer.inputs, outputs, layer.outputs, count);
+			Activation::apply(first.m_activation, outputs, count * layer.outputs);
+		}
+
+		// Give each network its values back
+		for (size_t network = 0; network < count; network++) {
+			float* networkValues = networks[network]->m_values.data();
+			for (const Layer& layer : first.m_layers)
+				memcpy(networkValues + layer.outputOffset, values + (count * layer.outputOffset) + (network * layer.outputs), layer.outputs * sizeof(float));
+		}
 	}
 };
\ No newline at end of file
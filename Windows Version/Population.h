@@ -0,0 +1,241 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "SimdKernels.h"
+#include "LifeForm.h"
+
+// Tells the compiler the arrays in the loop that follows never overlap, otherwise it won't vectorise loops touching this many of them
+#if defined(_MSC_VER)
+#define POPULATION_VECTORISE __pragma(loop(ivdep))
+#elif defined(__clang__)
+#define POPULATION_VECTORISE _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define POPULATION_VECTORISE _Pragma("GCC ivdep")
+#else
+#define POPULATION_VECTORISE
+#endif
+
+// How many angles move() gathers up at a time when it's given a list of lifeforms
+#define POPULATION_BLOCK_SIZE	64
+
+// The state of every lifeform kept as a structure of arrays.  The simple parts of each step (using up resources, turning,
+// moving and wrapping round the world) are done as a pass over a range of the population rather than one lifeform at a time.
+// The loops are written so the compiler can vectorise them, and the sin/cos of the new headings is done in one batch by SimdKernels.
+// LifeForm reads and writes its own entry through the accessors.  Mode is the experiment, see ExperimentMode.h
+template<class Mode>
+class Population {
+private:
+	float m_width, m_height;
+
+	std::vector<float> m_positionX, m_positionY;
+	std::vector<float> m_lastPositionX, m_lastPositionY;
+	std::vector<float> m_movementX, m_movementY;	// Direction moved last time
+	std::vector<float> m_angle;
+	std::vector<float> m_leftFoot, m_rightFoot;		// Outputs from the brain
+	std::vector<unsigned int> m_lifeSpan;
+	std::vector<int> m_cell;
+	std::vector<int> m_sun;							// Only used if the experiment has sunlight
+	std::vector<uint8_t> m_quickSand;				// Quicksand was under the lifeform last step, if the experiment has any
+	std::vector<uint8_t> m_active;					// Alive at the start of this step
+
+	// Maps the n'th lifeform of a pass to its index, for passes over a range or over a list
+	struct RangeIndex {
+		size_t first;
+		size_t operator[](const size_t n) const { return first + n; }
+	};
+	struct ListIndex {
+		const size_t* indices;
+		size_t operator[](const size_t n) const { return indices[n]; }
+	};
+
+	// Each of the passes.  The ones still alive become active, use up some of their resources and age
+	template<typename IndexAt>
+	void drainEach(const IndexAt at, const size_t count) {
+		uint8_t* activeFlag = m_active.data();
+		int* cell = m_cell.data();
+		int* sun = m_sun.data();
+		unsigned int* lifeSpan = m_lifeSpan.data();
+		const float* positionX = m_positionX.data();
+		const float* positionY = m_positionY.data();
+		float* lastPositionX = m_lastPositionX.data();
+		float* lastPositionY = m_lastPositionY.data();
+
+		POPULATION_VECTORISE
+		for (size_t n = 0; n < count; n++) {
+			const size_t index = at[n];
+			bool active = cell[index] > 0;
+			if constexpr (Mode::useSolar) {
+				active &= sun[index] > 0;
+				sun[index] -= active ? SUN_USED_PER_STEP : 0;
+			}
+			activeFlag[index] = active ? 1 : 0;
+			cell[index] -= active ? CELL_USED_PER_STEP : 0;
+			lifeSpan[index] += active ? 1 : 0;
+			const float x = positionX[index], y = positionY[index];
+			const float lastX = lastPositionX[index], lastY = lastPositionY[index];
+			lastPositionX[index] = active ? x : lastX;
+			lastPositionY[index] = active ? y : lastY;
+		}
+	}
+
+	// The two outputs from the brain represent the speed of the left and right 'feet'.  The angles are kept within +/-pi so
+	// sinCos() has very little range reduction to do.  Lifeforms that aren't active neither turn nor move, scaling by 0
+	// rather than skipping them keeps the loops free of branches
+	template<typename IndexAt>
+	void turnEach(const IndexAt at, const size_t count) {
+		const uint8_t* activeFlag = m_active.data();
+		const float* leftFoot = m_leftFoot.data();
+		const float* rightFoot = m_rightFoot.data();
+		float* angles = m_angle.data();
+		const float pi = (float)M_PI, twoPi = (float)(M_PI * 2.0);
+
+		POPULATION_VECTORISE
+		for (size_t n = 0; n < count; n++) {
+			const size_t index = at[n];
+			const float moving = activeFlag[index] ? 1.0f : 0.0f;
+			float angleChange = (rightFoot[index] - leftFoot[index]) * moving;
+			angleChange = angleChange < -MAX_TURN_SPEED ? -MAX_TURN_SPEED : angleChange;
+			angleChange = angleChange > MAX_TURN_SPEED ? MAX_TURN_SPEED : angleChange;
+			float angle = angles[index] + angleChange;
+			angle += angle > pi ? -twoPi : (angle < -pi ? twoPi : 0.0f);
+			angles[index] = angle;
+		}
+	}
+
+	// Move in the direction now faced
+	template<typename IndexAt>
+	void advanceEach(const IndexAt at, const size_t count) {
+		const uint8_t* activeFlag = m_active.data();
+		const float* leftFoot = m_leftFoot.data();
+		const float* rightFoot = m_rightFoot.data();
+		const float* movementsX = m_movementX.data();
+		const float* movementsY = m_movementY.data();
+		float* positionX = m_positionX.data();
+		float* positionY = m_positionY.data();
+		uint8_t* quickSand = m_quickSand.data();
+		const float width = m_width, height = m_height;
+
+		POPULATION_VECTORISE
+		for (size_t n = 0; n < count; n++) {
+			const size_t index = at[n];
+			const bool active = activeFlag[index] != 0;
+			float speedStep = (rightFoot[index] + leftFoot[index]) * (active ? 1.0f : 0.0f);
+
+			if constexpr (Mode::hasQuickSand) {
+				// It slows us down
+				const uint8_t sand = quickSand[index];
+				speedStep *= sand ? 0.25f : 1.0f;
+				quickSand[index] = active ? 0 : sand;
+			}
+
+			// The world wraps, if we go off an edge we appear on the opposite side
+			float x = positionX[index] + (movementsX[index] * speedStep);
+			float y = positionY[index] + (movementsY[index] * speedStep);
+			x += x < 0 ? width : (x >= width ? -width : 0.0f);
+			y += y < 0 ? height : (y >= height ? -height : 0.0f);
+			positionX[index] = x;
+			positionY[index] = y;
+		}
+	}
+
+public:
+	Population(const int width, const int height) : m_width((float)width), m_height((float)height) {}
+
+	// Make room for this many lifeforms
+	void resize(const size_t count) {
+		m_positionX.resize(count); m_positionY.resize(count);
+		m_lastPositionX.resize(count); m_lastPositionY.resize(count);
+		m_movementX.resize(count); m_movementY.resize(count);
+		m_angle.resize(count);
+		m_leftFoot.resize(count); m_rightFoot.resize(count);
+		m_lifeSpan.resize(count);
+		m_cell.resize(count);
+		if constexpr (Mode::useSolar) m_sun.resize(count);
+		if constexpr (Mode::hasQuickSand) m_quickSand.resize(count);
+		m_active.resize(count);
+	}
+
+	// Access to a single lifeform's state
+	FloatPair position(const size_t index) const { return { m_positionX[index], m_positionY[index] }; };
+	FloatPair lastPosition(const size_t index) const { return { m_lastPositionX[index], m_lastPositionY[index] }; };
+	FloatPair lastMovement(const size_t index) const { return { m_movementX[index], m_movementY[index] }; };
+	float angle(const size_t index) const { return m_angle[index]; };
+	unsigned int& lifeSpan(const size_t index) { return m_lifeSpan[index]; };
+	int& cell(const size_t index) { return m_cell[index]; };
+	int& sun(const size_t index) { return m_sun[index]; };
+	uint8_t& quickSand(const size_t index) { return m_quickSand[index]; };
+	bool isActive(const size_t index) const { return m_active[index] != 0; };
+
+	// Returns TRUE if the lifeform still has the resources to live
+	bool isAlive(const size_t index) const {
+		if constexpr (Mode::useSolar) return (m_cell[index] > 0) && (m_sun[index] > 0);
+		else return m_cell[index] > 0;
+	}
+
+	// Put a lifeform somewhere new facing a new direction (0 to 2*pi)
+	void place(const size_t index, const FloatPair& position, const float angle) {
+		m_positionX[index] = m_lastPositionX[index] = position.x;
+		m_positionY[index] = m_lastPositionY[index] = position.y;
+		m_angle[index] = angle > (float)M_PI ? angle - (float)(M_PI * 2.0) : angle;
+		SimdKernels::sinCos(&m_angle[index], &m_movementY[index], &m_movementX[index], 1);
+	}
+
+	// Store the outputs from a lifeform's brain ready for move()
+	void setOutputs(const size_t index, const float leftFoot, const float rightFoot) {
+		m_leftFoot[index] = leftFoot;
+		m_rightFoot[index] = rightFoot;
+	}
+
+	// Start a step for lifeforms [first, last).  The ones still alive become active, use up some of their resources and age
+	void drain(const size_t first, const size_t last) {
+		if (last > first) drainEach(RangeIndex{ first }, last - first);
+	}
+
+	// The same for a list of lifeform indices, in ascending order
+	void drain(const size_t* indices, const size_t count) {
+		if (count < 1) return;
+		if (indices[count - 1] - indices[0] == count - 1) drain(indices[0], indices[0] + count);
+		else drainEach(ListIndex{ indices }, count);
+	}
+
+	// Turn and move the active lifeforms in [first, last) using the outputs from their brains
+	void move(const size_t first, const size_t last) {
+		if (last <= first) return;
+		turnEach(RangeIndex{ first }, last - first);
+		SimdKernels::sinCos(m_angle.data() + first, m_movementY.data() + first, m_movementX.data() + first, last - first);
+		advanceEach(RangeIndex{ first }, last - first);
+	}
+
+	// The same for a list of lifeform indices, in ascending order
+	void move(const size_t* indices, const size_t count) {
+		if (count < 1) return;
+		if (indices[count - 1] - indices[0] == count - 1) {
+			move(indices[0], indices[0] + count);
+			return;
+		}
+
+		// The angles are gathered up a block at a time for sinCos()
+		turnEach(ListIndex{ indices }, count);
+		float angles[POPULATION_BLOCK_SIZE], sines[POPULATION_BLOCK_SIZE], cosines[POPULATION_BLOCK_SIZE];
+		for (size_t start = 0; start < count; start += POPULATION_BLOCK_SIZE) {
+			const size_t blockSize = (count - start < POPULATION_BLOCK_SIZE) ? count - start : POPULATION_BLOCK_SIZE;
+			for (size_t n = 0; n < blockSize; n++) angles[n] = m_angle[indices[start + n]];
+			SimdKernels::sinCos(angles, sines, cosines, blockSize);
+			for (size_t n = 0; n < blockSize; n++) {
+				m_movementY[indices[start + n]] = sines[n];
+				m_movementX[indices[start + n]] = cosines[n];
+			}
+		}
+		advanceEach(ListIndex{ indices }, count);
+	}
+};
@@ -0,0 +1,66 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// What a random stream is being used for.  Combined with an index (and generation) to give every user its own stream
+enum class RandomPurpose : uint64_t { rpWorld = 1, rpLifeform, rpGenome, rpSelection, rpBrain };
+
+// Counter based random number generator (SplitMix64).  Every number is a hash of the stream's key and a counter, so there's
+// no shared state.  Any number of independent streams can be made from one run seed, and a stream produces the same
+// numbers no matter which thread uses it.  This replaces rand() which isn't thread safe and on MSVC only has 15 bits
+class RandomStream {
+private:
+	uint64_t m_key = 0;
+	uint64_t m_counter = 0;
+
+	// SplitMix64 finaliser
+	static uint64_t mix(uint64_t value) {
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+
+public:
+	RandomStream() {}
+
+	// A stream for a particular purpose, eg. (seed, RandomPurpose::rpLifeform, lifeformIndex, generation)
+	RandomStream(const uint64_t seed, const RandomPurpose purpose, const uint64_t index = 0, const uint64_t generation = 0) {
+		reset(seed, purpose, index, generation);
+	}
+
+	// Switch to a different stream and start from the beginning of it
+	void reset(const uint64_t seed, const RandomPurpose purpose, const uint64_t index = 0, const uint64_t generation = 0) {
+		m_key = mix(mix(mix(seed + (uint64_t)purpose) + index) + generation);
+		m_counter = 0;
+	}
+
+	// Next random 64-bit number
+	uint64_t next() {
+		return mix(m_key + (++m_counter * 0x9E3779B97F4A7C15ULL));
+	}
+
+	// Random number from 0 to 1 (not including 1)
+	float nextFloat() {
+		return (float)(next() >> 40) * (1.0f / 16777216.0f);
+	}
+
+	// Random number from 0 to 1 (not including 1) in double precision
+	double nextDouble() {
+		return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	// Random whole number from 0 to count-1
+	size_t nextIndex(const size_t count) {
+		return (size_t)(nextDouble() * (double)count);
+	}
+};
@@ -0,0 +1,65 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "SimdKernels.h"
+
+// The resources' positions, sizes and types laid out as separate arrays so they can be scanned with SIMD.
+// The arrays are padded with entries of type -1 so the kernels never have to deal with a partial block
+class ResourceTable {
+private:
+	std::vector<float> m_x;
+	std::vector<float> m_y;
+	std::vector<int32_t> m_radiusSquared;
+	std::vector<int32_t> m_type;
+	size_t m_count = 0;
+
+public:
+	// Number of resources in the table
+	size_t size() const {
+		return m_count;
+	}
+
+	// Add a resource to the end of the table
+	void add(const float x, const float y, const int radiusSquared, const int type) {
+		if (m_count == m_type.size()) {
+			const size_t padded = m_count + SIMD_NEAREST_PADDING;
+			m_x.resize(padded, 0.0f);
+			m_y.resize(padded, 0.0f);
+			m_radiusSquared.resize(padded, 0);
+			m_type.resize(padded, -1);
+		}
+		m_x[m_count] = x;
+		m_y[m_count] = y;
+		m_radiusSquared[m_count] = radiusSquared;
+		m_type[m_count] = type;
+		m_count++;
+	}
+
+	// Update a resource's position
+	void move(const size_t index, const float x, const float y) {
+		m_x[index] = x;
+		m_y[index] = y;
+	}
+
+	// The squared distances are worked out in 32 bits, so the table can only be used if the furthest anything can be
+	// (half way across the world each way, as it wraps round) fits in one
+	static bool canScan(const int width, const int height) {
+		const int64_t halfWidth = width / 2, halfHeight = height / 2;
+		return (halfWidth * halfWidth) + (halfHeight * halfHeight) <= INT32_MAX;
+	}
+
+	// Finds the nearest resource of each type (0 to numTypes-1) to (x, y), and how far the next nearest is.  See SimdKernels::nearest()
+	void nearest(const float x, const float y, const int width, const int height, const int numTypes, int32_t* nearestIndex, int32_t* nearestDistance, int32_t* secondDistance) const {
+		SimdKernels::nearest(m_x.data(), m_y.data(), m_radiusSquared.data(), m_type.data(), m_type.size(), x, y, width, height, numTypes, nearestIndex, nearestDistance, secondDistance);
+	}
+};
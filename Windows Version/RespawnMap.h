@@ -0,0 +1,85 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+
+// Keeps track of where resources have re-spawned, so anything remembering what was near it can tell if something new has
+// turned up since.  Every re-spawn is numbered, and the world (which wraps at the edges) is cut into blocks that each keep
+// the number of the last re-spawn in them.  Safe to use from several threads at once
+class RespawnMap {
+private:
+	int m_columns, m_rows;
+	float m_blockWidth, m_blockHeight;
+	std::vector<std::atomic<uint64_t>> m_blocks;
+	std::atomic<uint64_t> m_count;
+
+	// Block index containing a point, wrapping if its off the edge
+	int blockAt(const float x, const float y) const {
+		int column = (int)(x / m_blockWidth) % m_columns;
+		int row = (int)(y / m_blockHeight) % m_rows;
+		if (column < 0) column += m_columns;
+		if (row < 0) row += m_rows;
+		return (row * m_columns) + column;
+	}
+
+public:
+	// No block is smaller than blockSize (unless the world is), they're enlarged until the world divides into them evenly
+	RespawnMap(const int width, const int height, const int blockSize) : m_count(0) {
+		m_columns = width / blockSize;
+		m_rows = height / blockSize;
+		if (m_columns < 1) m_columns = 1;
+		if (m_rows < 1) m_rows = 1;
+		m_blockWidth = (float)width / (float)m_columns;
+		m_blockHeight = (float)height / (float)m_rows;
+		m_blocks = std::vector<std::atomic<uint64_t>>((size_t)m_columns * (size_t)m_rows);
+		for (std::atomic<uint64_t>& block : m_blocks) block.store(0, std::memory_order_relaxed);
+	}
+
+	// Number of re-spawns so far.  Read this before looking at the resources
+	uint64_t count() const {
+		return m_count.load();
+	}
+
+	// A resource has re-spawned at (x, y).  Call this once it's there
+	void respawned(const float x, const float y) {
+		const uint64_t number = m_count.fetch_add(1) + 1;
+		std::atomic<uint64_t>& block = m_blocks[blockAt(x, y)];
+		uint64_t last = block.load(std::memory_order_relaxed);
+		while ((last < number) && (!block.compare_exchange_weak(last, number)));
+	}
+
+	// Returns TRUE if anything might have re-spawned within radius of (x, y) since count() was 'since'.  It checks every
+	// block the circle touches, so it can also say TRUE for something a little further away
+	bool respawnedNear(const float x, const float y, const float radius, const uint64_t since) const {
+		if (m_count.load() == since) return false;
+
+		const int block = blockAt(x, y);
+		const int column = block % m_columns;
+		const int row = block / m_columns;
+		int spanX = (int)(radius / m_blockWidth) + 1;
+		int spanY = (int)(radius / m_blockHeight) + 1;
+
+		// Don't go round the world and check the same blocks twice
+		int firstX = column - spanX, lastX = column + spanX;
+		int firstY = row - spanY, lastY = row + spanY;
+		if ((spanX * 2) + 1 >= m_columns) { firstX = 0; lastX = m_columns - 1; }
+		if ((spanY * 2) + 1 >= m_rows) { firstY = 0; lastY = m_rows - 1; }
+
+		for (int y = firstY; y <= lastY; y++) {
+			const int wrappedY = (y + m_rows) % m_rows;
+			for (int x = firstX; x <= lastX; x++)
+				if (m_blocks[(wrappedY * m_columns) + ((x + m_columns) % m_columns)].load(std::memory_order_relaxed) > since) return true;
+		}
+		return false;
+	}
+};
@@ -0,0 +1,591 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#define _USE_MATH_DEFINES // for C++
+#include <cmath>
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need to be told which functions are allowed to use the wider instruction sets. MSVC doesn't
+#if defined(SIMD_X86) && !defined(_MSC_VER)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+// Instruction sets we have kernels for
+enum class SimdLevel { slScalar, slAVX2, slAVX512 };
+
+// The maths kernels used by the neural network.  The best version for the CPU is chosen at runtime.
+//
+// The SIMD versions sum the weights in a different order to the scalar one, and use a polynomial exp() rather than pow().
+// Compared to the scalar path the neuron outputs (after the sigmoid) agree to within SIMD_SIGMOID_TOLERANCE
+#define SIMD_SIGMOID_TOLERANCE		1e-6f
+
+// nearest() handles up to this many resource types, and the arrays it scans must be padded to a multiple of SIMD_NEAREST_PADDING
+#define SIMD_NEAREST_MAX_TYPES		8
+#define SIMD_NEAREST_PADDING		16
+
+// sinCos() uses the Cephes sinf/cosf polynomials and reduces the angle by pi/4 in three parts.  Every version does the same
+// steps in the same order, so they agree exactly unless the compiler fuses a multiply and add.  Against double precision
+// sin/cos the error is at most SIMD_SINCOS_TOLERANCE for angles within +/-8192, which is as far as the reduction is accurate
+#define SIMD_SINCOS_TOLERANCE		1.2e-7f
+#define SIMD_SINCOS_FOUR_OVER_PI	1.27323954473516f
+#define SIMD_SINCOS_DP1				0.78515625f
+#define SIMD_SINCOS_DP2				2.4187564849853515625e-4f
+#define SIMD_SINCOS_DP3				3.77489497744594108e-8f
+#define SIMD_SINCOS_S0				-1.9515295891e-4f
+#define SIMD_SINCOS_S1				8.3321608736e-3f
+#define SIMD_SINCOS_S2				-1.6666654611e-1f
+#define SIMD_SINCOS_C0				2.443315711809948e-5f
+#define SIMD_SINCOS_C1				-1.388731625493765e-3f
+#define SIMD_SINCOS_C2				4.166664568298827e-2f
+
+class SimdKernels {
+public:
+	// Calculates outputs[n] = dot(weights + (n * stride), inputs) for each of the numOutputs rows
+	typedef void (*DotRowsFunction)(const float* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs);
+	// dotRows for a batch of count matrices that are the same shape.  Matrix m starts at weights[m], its inputs are at
+	// inputs + (m * numInputs) and its outputs go to outputs + (m * numOutputs)
+	typedef void (*DotRowsBatchFunction)(const float* const* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs, size_t count);
+	// Replaces each value with its sigmoid
+	typedef void (*SigmoidFunction)(float* values, size_t count);
+	// Finds the nearest and second nearest of each type of resource to (x, y) in a world that wraps.  See nearest() below
+	typedef void (*NearestFunction)(const float* xs, const float* ys, const int32_t* radiusSquared, const int32_t* types, size_t count,
+		float x, float y, int32_t width, int32_t height, int numTypes, int32_t* nearestIndex, int32_t* nearestDistance, int32_t* secondDistance);
+	// Calculates the sine and cosine of each angle
+	typedef void (*SinCosFunction)(const float* angles, float* sines, float* cosines, size_t count);
+
+private:
+	struct Kernels {
+		SimdLevel level;
+		DotRowsFunction dotRows;
+		DotRowsBatchFunction dotRowsBatch;
+		SigmoidFunction sigmoid;
+		NearestFunction nearest;
+		SinCosFunction sinCos;
+	};
+
+	// The kernels currently in use
+	static Kernels& active() {
+		static Kernels kernels = kernelsFor(detect());
+		return kernels;
+	}
+
+	// Scalar versions.  These match the original neuron code exactly
+	static void dotRowsScalar(const float* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs) {
+		for (size_t neuron = 0; neuron < numOutputs; neuron++, weights += stride) {
+			float total = 0;
+			for (size_t input = 0; input < numInputs; input++)
+				total += weights[input] * inputs[input];
+			outputs[neuron] = total;
+		}
+	}
+	static void dotRowsBatchScalar(const float* const* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs, size_t count) {
+		for (size_t matrix = 0; matrix < count; matrix++, inputs += numInputs, outputs += numOutputs)
+			dotRowsScalar(weights[matrix], stride, inputs, numInputs, outputs, numOutputs);
+	}
+	static void sigmoidScalar(float* values, size_t count) {
+		for (size_t index = 0; index < count; index++)
+			values[index] = sigmoid(values[index]);
+	}
+	static void nearestScalar(const float* xs, const float* ys, const int32_t* radiusSquared, const int32_t* types, size_t count,
+		float x, float y, int32_t width, int32_t height, int numTypes, int32_t* nearestIndex, int32_t* nearestDistance, int32_t* secondDistance) {
+		for (int type = 0; type < numTypes; type++) {
+			nearestIndex[type] = -1;
+			secondDistance[type] = INT32_MAX;
+		}
+		for (size_t index = 0; index < count; index++) {
+			const int32_t type = types[index];
+			if ((type < 0) || (type >= numTypes)) continue;
+
+			int32_t distanceX = (int32_t)fabsf(x - (float)(int32_t)xs[index]);
+			int32_t distanceY = (int32_t)fabsf(y - (float)(int32_t)ys[index]);
+			if (distanceX > width / 2) distanceX = width - distanceX;
+			if (distanceY > height / 2) distanceY = height - distanceY;
+			int32_t distance = ((distanceX * distanceX) + (distanceY * distanceY)) - radiusSquared[index];
+			if (distance < 0) distance = 0;
+
+			if ((nearestIndex[type] == -1) || (distance < nearestDistance[type])) {
+				if (nearestIndex[type] != -1) secondDistance[type] = nearestDistance[type];
+				nearestIndex[type] = (int32_t)index;
+				nearestDistance[type] = distance;
+			}
+			else if (distance < secondDistance[type]) secondDistance[type] = distance;
+		}
+	}
+
+	static void sinCosScalar(const float* angles, float* sines, float* cosines, size_t count) {
+		for (size_t index = 0; index < count; index++) {
+			const float angle = angles[index];
+			const float x = fabsf(angle);
+			const int32_t octant = ((int32_t)(x * SIMD_SINCOS_FOUR_OVER_PI) + 1) & ~1;
+			const float y = (float)octant;
+			const float z = ((x - (y * SIMD_SINCOS_DP1)) - (y * SIMD_SINCOS_DP2)) - (y * SIMD_SINCOS_DP3);
+			const float zz = z * z;
+			const float cosPoly = (((((((SIMD_SINCOS_C0 * zz) + SIMD_SINCOS_C1) * zz) + SIMD_SINCOS_C2) * zz) * zz) - (0.5f * zz)) + 1.0f;
+			const float sinPoly = ((((((SIMD_SINCOS_S0 * zz) + SIMD_SINCOS_S1) * zz) + SIMD_SINCOS_S2) * zz) * z) + z;
+
+			// Pick the polynomial and sign for the quadrant
+			const bool swap = (octant & 2) != 0;
+			const bool negativeSine = ((octant & 4) != 0) != std::signbit(angle);
+			const bool negativeCosine = ((octant + 2) & 4) != 0;
+			const float sine = swap ? cosPoly : sinPoly;
+			const float cosine = swap ? sinPoly : cosPoly;
+			sines[index] = negativeSine ? -sine : sine;
+			cosines[index] = negativeCosine ? -cosine : cosine;
+		}
+	}
+
+	// Combine the nearest found in each SIMD lane.  On a tie the lowest index wins, the same as checking them in order.
+	// The second nearest is the nearest of everything else, which is the other lanes' nearest and every lane's second
+	static void nearestFromLanes(const int32_t* laneIndex, const int32_t* laneDistance, const int32_t* laneSecond, size_t lanes,
+		int32_t& nearestIndex, int32_t& nearestDistance, int32_t& secondDistance) {
+		nearestIndex = -1;
+		size_t nearestLane = 0;
+		for (size_t lane = 0; lane < lanes; lane++) {
+			if (laneIndex[lane] < 0) continue;
+			if ((nearestIndex == -1) || (laneDistance[lane] < nearestDistance) || ((laneDistance[lane] == nearestDistance) && (laneIndex[lane] < nearestIndex))) {
+				nearestIndex = laneIndex[lane];
+				nearestDistance = laneDistance[lane];
+				nearestLane = lane;
+			}
+		}
+		secondDistance = INT32_MAX;
+		for (size_t lane = 0; lane < lanes; lane++) {
+			if (laneSecond[lane] < secondDistance) secondDistance = laneSecond[lane];
+			if ((lane != nearestLane) && (laneIndex[lane] >= 0) && (laneDistance[lane] < secondDistance)) secondDistance = laneDistance[lane];
+		}
+	}
+
+#ifdef SIMD_X86
+	// Cephes style exp() polynomial, accurate to about 2 ULP over the range we clamp to
+	static constexpr float expMin = -87.3f;
+	static constexpr float expMax = 88.3f;
+	static constexpr float log2e = 1.44269504088896341f;
+	static constexpr float ln2Hi = 0.693359375f;
+	static constexpr float ln2Lo = -2.12194440e-4f;
+	static constexpr float expP0 = 1.9875691500e-4f;
+	static constexpr float expP1 = 1.3981999507e-3f;
+	static constexpr float expP2 = 8.3334519073e-3f;
+	static constexpr float expP3 = 4.1665795894e-2f;
+	static constexpr float expP4 = 1.6666665459e-1f;
+	static constexpr float expP5 = 5.0000001201e-1f;
+
+	// AVX2: Returns a mask to load just the first 'count' (0-8) floats
+	SIMD_TARGET("avx2,fma") static __m256i tailMaskAVX2(size_t count) {
+		static const int32_t maskTable[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+		return _mm256_loadu_si256((const __m256i*)(maskTable + 8 - count));
+	}
+
+	SIMD_TARGET("avx2,fma") static float horizontalSumAVX2(__m256 value) {
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+		return _mm_cvtss_f32(sum);
+	}
+
+	SIMD_TARGET("avx2,fma") static __m256 expAVX2(__m256 x) {
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(expMin)), _mm256_set1_ps(expMax));
+
+		// Split into 2^n * e^r where |r| <= ln(2)/2
+		const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2Hi), x);
+		r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2Lo), r);
+
+		__m256 p = _mm256_set1_ps(expP0);
+		p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP1));
+		p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP2));
+		p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP3));
+		p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP4));
+		p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(expP5));
+		p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r);
+		p = _mm256_add_ps(p, _mm256_set1_ps(1.0f));
+
+		// Multiply by 2^n by building the exponent directly
+		const __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+	}
+
+	SIMD_TARGET("avx2,fma") static void dotRowsAVX2(const float* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs) {
+		const size_t tail = numInputs & 7;
+		const size_t bulk = numInputs - tail;
+		const __m256i mask = tailMaskAVX2(tail);
+
+		for (size_t neuron = 0; neuron < numOutputs; neuron++, weights += stride) {
+			__m256 total = _mm256_setzero_ps();
+			for (size_t input = 0; input < bulk; input += 8)
+				total = _mm256_fmadd_ps(_mm256_loadu_ps(weights + input), _mm256_loadu_ps(inputs + input), total);
+			if (tail)
+				total = _mm256_fmadd_ps(_mm256_maskload_ps(weights + bulk, mask), _mm256_maskload_ps(inputs + bulk, mask), total);
+			outputs[neuron] = horizontalSumAVX2(total);
+		}
+	}
+	SIMD_TARGET("avx2,fma") static void dotRowsBatchAVX2(const float* const* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs, size_t count) {
+		for (size_t matrix = 0; matrix < count; matrix++, inputs += numInputs, outputs += numOutputs)
+			dotRowsAVX2(weights[matrix], stride, inputs, numInputs, outputs, numOutputs);
+	}
+
+	SIMD_TARGET("avx2,fma") static void sigmoidAVX2(float* values, size_t count) {
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		size_t index = 0;
+		for (; index + 8 <= count; index += 8) {
+			const __m256 e = expAVX2(_mm256_sub_ps(zero, _mm256_loadu_ps(values + index)));
+			_mm256_storeu_ps(values + index, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+		}
+		if (index < count) {
+			const __m256i mask = tailMaskAVX2(count - index);
+			const __m256 e = expAVX2(_mm256_sub_ps(zero, _mm256_maskload_ps(values + index, mask)));
+			_mm256_maskstore_ps(values + index, mask, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+		}
+	}
+
+	// The same steps as sinCosScalar(), eight at a time
+	SIMD_TARGET("avx2,fma") static void sinCosAVX2(__m256 angle, __m256& sine, __m256& cosine) {
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		const __m256 x = _mm256_andnot_ps(signBit, angle);
+		const __m256i octant = _mm256_and_si256(_mm256_add_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(SIMD_SINCOS_FOUR_OVER_PI))), _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+		const __m256 y = _mm256_cvtepi32_ps(octant);
+		__m256 z = _mm256_sub_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(SIMD_SINCOS_DP1)));
+		z = _mm256_sub_ps(z, _mm256_mul_ps(y, _mm256_set1_ps(SIMD_SINCOS_DP2)));
+		z = _mm256_sub_ps(z, _mm256_mul_ps(y, _mm256_set1_ps(SIMD_SINCOS_DP3)));
+		const __m256 zz = _mm256_mul_ps(z, z);
+
+		__m256 cosPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIMD_SINCOS_C0), zz), _mm256_set1_ps(SIMD_SINCOS_C1));
+		cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, zz), _mm256_set1_ps(SIMD_SINCOS_C2));
+		cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, zz), zz);
+		cosPoly = _mm256_add_ps(_mm256_sub_ps(cosPoly, _mm256_mul_ps(_mm256_set1_ps(0.5f), zz)), _mm256_set1_ps(1.0f));
+		__m256 sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIMD_SINCOS_S0), zz), _mm256_set1_ps(SIMD_SINCOS_S1));
+		sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, zz), _mm256_set1_ps(SIMD_SINCOS_S2));
+		sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, zz), z), z);
+
+		// Pick the polynomial and sign for the quadrant
+		const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+		const __m256 sineSign = _mm256_xor_ps(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(octant, _mm256_set1_epi32(4)), 29)), _mm256_and_ps(angle, signBit));
+		const __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+		sine = _mm256_xor_ps(_mm256_blendv_ps(sinPoly, cosPoly, swap), sineSign);
+		cosine = _mm256_xor_ps(_mm256_blendv_ps(cosPoly, sinPoly, swap), cosineSign);
+	}
+
+	SIMD_TARGET("avx2,fma") static void sinCosAVX2(const float* angles, float* sines, float* cosines, size_t count) {
+		__m256 sine, cosine;
+		size_t index = 0;
+		for (; index + 8 <= count; index += 8) {
+			sinCosAVX2(_mm256_loadu_ps(angles + index), sine, cosine);
+			_mm256_storeu_ps(sines + index, sine);
+			_mm256_storeu_ps(cosines + index, cosine);
+		}
+		if (index < count) {
+			const __m256i mask = tailMaskAVX2(count - index);
+			sinCosAVX2(_mm256_maskload_ps(angles + index, mask), sine, cosine);
+			_mm256_maskstore_ps(sines + index, mask, sine);
+			_mm256_maskstore_ps(cosines + index, mask, cosine);
+		}
+	}
+
+	// Eight resources at a time.  Each lane keeps its own nearest and second nearest of each type, and they're combined at the end
+	SIMD_TARGET("avx2,fma") static void nearestAVX2(const float* xs, const float* ys, const int32_t* radiusSquared, const int32_t* types, size_t count,
+		float x, float y, int32_t width, int32_t height, int numTypes, int32_t* nearestIndex, int32_t* nearestDistance, int32_t* secondDistance) {
+		const __m256 px = _mm256_set1_ps(x), py = _mm256_set1_ps(y);
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		const __m256i worldWidth = _mm256_set1_epi32(width), worldHeight = _mm256_set1_epi32(height);
+		const __m256i halfWidth = _mm256_set1_epi32(width / 2), halfHeight = _mm256_set1_epi32(height / 2);
+		const __m256i zero = _mm256_setzero_si256();
+
+		__m256i best[SIMD_NEAREST_MAX_TYPES], bestIndex[SIMD_NEAREST_MAX_TYPES], second[SIMD_NEAREST_MAX_TYPES];
+		for (int type = 0; type < numTypes; type++) {
+			best[type] = _mm256_set1_epi32(INT32_MAX);
+			bestIndex[type] = _mm256_set1_epi32(-1);
+			second[type] = _mm256_set1_epi32(INT32_MAX);
+		}
+
+		__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		for (size_t block = 0; block < count; block += 8) {
+			// The same sums as the scalar version, including rounding the centre down to a whole pixel
+			const __m256 cx = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_loadu_ps(xs + block)));
+			const __m256 cy = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_loadu_ps(ys + block)));
+			__m256i distanceX = _mm256_cvttps_epi32(_mm256_and_ps(_mm256_sub_ps(px, cx), absMask));
+			__m256i distanceY = _mm256_cvttps_epi32(_mm256_and_ps(_mm256_sub_ps(py, cy), absMask));
+			distanceX = _mm256_blendv_epi8(distanceX, _mm256_sub_epi32(worldWidth, distanceX), _mm256_cmpgt_epi32(distanceX, halfWidth));
+			distanceY = _mm256_blendv_epi8(distanceY, _mm256_sub_epi32(worldHeight, distanceY), _mm256_cmpgt_epi32(distanceY, halfHeight));
+			__m256i distance = _mm256_add_epi32(_mm256_mullo_epi32(distanceX, distanceX), _mm256_mullo_epi32(distanceY, distanceY));
+			distance = _mm256_max_epi32(_mm256_sub_epi32(distance, _mm256_loadu_si256((const __m256i*)(radiusSquared + block))), zero);
+
+			const __m256i blockTypes = _mm256_loadu_si256((const __m256i*)(types + block));
+			for (int type = 0; type < numTypes; type++) {
+				const __m256i isType = _mm256_cmpeq_epi32(blockTypes, _mm256_set1_epi32(type));
+				const __m256i nearer = _mm256_and_si256(isType, _mm256_cmpgt_epi32(best[type], distance));
+				// Whichever of the old nearest and this one loses might be the second nearest
+				const __m256i runnerUp = _mm256_blendv_epi8(distance, best[type], nearer);
+				second[type] = _mm256_blendv_epi8(second[type], _mm256_min_epi32(second[type], runnerUp), isType);
+				best[type] = _mm256_blendv_epi8(best[type], distance, nearer);
+				bestIndex[type] = _mm256_blendv_epi8(bestIndex[type], index, nearer);
+			}
+			index = _mm256_add_epi32(index, _mm256_set1_epi32(8));
+		}
+
+		int32_t laneIndex[8], laneDistance[8], laneSecond[8];
+		for (int type = 0; type < numTypes; type++) {
+			_mm256_storeu_si256((__m256i*)laneIndex, bestIndex[type]);
+			_mm256_storeu_si256((__m256i*)laneDistance, best[type]);
+			_mm256_storeu_si256((__m256i*)laneSecond, second[type]);
+			nearestFromLanes(laneIndex, laneDistance, laneSecond, 8, nearestIndex[type], nearestDistance[type], secondDistance[type]);
+		}
+	}
+
+	// AVX-512: Returns a mask for just the first 'count' (0-16) floats
+	static __mmask16 tailMaskAVX512(size_t count) {
+		return (__mmask16)((1u << count) - 1);
+	}
+
+	SIMD_TARGET("avx512f") static __m512 expAVX512(__m512 x) {
+		x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(expMin)), _mm512_set1_ps(expMax));
+
+		// Split into 2^n * e^r where |r| <= ln(2)/2
+		const __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2Hi), x);
+		r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2Lo), r);
+
+		__m512 p = _mm512_set1_ps(expP0);
+		p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP1));
+		p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP2));
+		p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP3));
+		p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP4));
+		p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(expP5));
+		p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r);
+		p = _mm512_add_ps(p, _mm512_set1_ps(1.0f));
+
+		// Multiply by 2^n
+		return _mm512_scalef_ps(p, n);
+	}
+
+	SIMD_TARGET("avx512f") static void dotRowsAVX512(const float* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs) {
+		const size_t tail = numInputs & 15;
+		const size_t bulk = numInputs - tail;
+		const __mmask16 mask = tailMaskAVX512(tail);
+
+		for (size_t neuron = 0; neuron < numOutputs; neuron++, weights += stride) {
+			__m512 total = _mm512_setzero_ps();
+			for (size_t input = 0; input < bulk; input += 16)
+				total = _mm512_fmadd_ps(_mm512_loadu_ps(weights + input), _mm512_loadu_ps(inputs + input), total);
+			if (tail)
+				total = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, weights + bulk), _mm512_maskz_loadu_ps(mask, inputs + bulk), total);
+			outputs[neuron] = _mm512_reduce_add_ps(total);
+		}
+	}
+	SIMD_TARGET("avx512f") static void dotRowsBatchAVX512(const float* const* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs, size_t count) {
+		for (size_t matrix = 0; matrix < count; matrix++, inputs += numInputs, outputs += numOutputs)
+			dotRowsAVX512(weights[matrix], stride, inputs, numInputs, outputs, numOutputs);
+	}
+
+	SIMD_TARGET("avx512f") static void sigmoidAVX512(float* values, size_t count) {
+		const __m512 one = _mm512_set1_ps(1.0f);
+		const __m512 zero = _mm512_setzero_ps();
+		size_t index = 0;
+		for (; index + 16 <= count; index += 16) {
+			const __m512 e = expAVX512(_mm512_sub_ps(zero, _mm512_loadu_ps(values + index)));
+			_mm512_storeu_ps(values + index, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+		}
+		if (index < count) {
+			const __mmask16 mask = tailMaskAVX512(count - index);
+			const __m512 e = expAVX512(_mm512_sub_ps(zero, _mm512_maskz_loadu_ps(mask, values + index)));
+			_mm512_mask_storeu_ps(values + index, mask, _mm512_div_ps(one, _mm512_add_ps(one, e)));
+		}
+	}
+
+	// The same steps as sinCosScalar(), sixteen at a time.  Only AVX-512F, so the bit operations are done on integers
+	SIMD_TARGET("avx512f") static void sinCosAVX512(__m512 angle, __m512& sine, __m512& cosine) {
+		const __m512i bits = _mm512_castps_si512(angle);
+		const __m512i signBit = _mm512_set1_epi32((int32_t)0x80000000);
+		const __m512 x = _mm512_castsi512_ps(_mm512_andnot_si512(signBit, bits));
+		const __m512i octant = _mm512_and_si512(_mm512_add_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(x, _mm512_set1_ps(SIMD_SINCOS_FOUR_OVER_PI))), _mm512_set1_epi32(1)), _mm512_set1_epi32(~1));
+		const __m512 y = _mm512_cvtepi32_ps(octant);
+		__m512 z = _mm512_sub_ps(x, _mm512_mul_ps(y, _mm512_set1_ps(SIMD_SINCOS_DP1)));
+		z = _mm512_sub_ps(z, _mm512_mul_ps(y, _mm512_set1_ps(SIMD_SINCOS_DP2)));
+		z = _mm512_sub_ps(z, _mm512_mul_ps(y, _mm512_set1_ps(SIMD_SINCOS_DP3)));
+		const __m512 zz = _mm512_mul_ps(z, z);
+
+		__m512 cosPoly = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(SIMD_SINCOS_C0), zz), _mm512_set1_ps(SIMD_SINCOS_C1));
+		cosPoly = _mm512_add_ps(_mm512_mul_ps(cosPoly, zz), _mm512_set1_ps(SIMD_SINCOS_C2));
+		cosPoly = _mm512_mul_ps(_mm512_mul_ps(cosPoly, zz), zz);
+		cosPoly = _mm512_add_ps(_mm512_sub_ps(cosPoly, _mm512_mul_ps(_mm512_set1_ps(0.5f), zz)), _mm512_set1_ps(1.0f));
+		__m512 sinPoly = _mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(SIMD_SINCOS_S0), zz), _mm512_set1_ps(SIMD_SINCOS_S1));
+		sinPoly = _mm512_add_ps(_mm512_mul_ps(sinPoly, zz), _mm512_set1_ps(SIMD_SINCOS_S2));
+		sinPoly = _mm512_add_ps(_mm512_mul_ps(_mm512_mul_ps(sinPoly, zz), z), z);
+
+		// Pick the polynomial and sign for the quadrant
+		const __mmask16 swap = _mm512_test_epi32_mask(octant, _mm512_set1_epi32(2));
+		const __m512i sineSign = _mm512_xor_si512(_mm512_slli_epi32(_mm512_and_si512(octant, _mm512_set1_epi32(4)), 29), _mm512_and_si512(bits, signBit));
+		const __m512i cosineSign = _mm512_slli_epi32(_mm512_and_si512(_mm512_add_epi32(octant, _mm512_set1_epi32(2)), _mm512_set1_epi32(4)), 29);
+		sine = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(swap, sinPoly, cosPoly)), sineSign));
+		cosine = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(_mm512_mask_blend_ps(swap, cosPoly, sinPoly)), cosineSign));
+	}
+
+	SIMD_TARGET("avx512f") static void sinCosAVX512(const float* angles, float* sines, float* cosines, size_t count) {
+		__m512 sine, cosine;
+		size_t index = 0;
+		for (; index + 16 <= count; index += 16) {
+			sinCosAVX512(_mm512_loadu_ps(angles + index), sine, cosine);
+			_mm512_storeu_ps(sines + index, sine);
+			_mm512_storeu_ps(cosines + index, cosine);
+		}
+		if (index < count) {
+			const __mmask16 mask = tailMaskAVX512(count - index);
+			sinCosAVX512(_mm512_maskz_loadu_ps(mask, angles + index), sine, cosine);
+			_mm512_mask_storeu_ps(sines + index, mask, sine);
+			_mm512_mask_storeu_ps(cosines + index, mask, cosine);
+		}
+	}
+
+	// Sixteen resources at a time
+	SIMD_TARGET("avx512f") static void nearestAVX512(const float* xs, const float* ys, const int32_t* radiusSquared, const int32_t* types, size_t count,
+		float x, float y, int32_t width, int32_t height, int numTypes, int32_t* nearestIndex, int32_t* nearestDistance, int32_t* secondDistance) {
+		const __m512 px = _mm512_set1_ps(x), py = _mm512_set1_ps(y);
+		const __m512i worldWidth = _mm512_set1_epi32(width), worldHeight = _mm512_set1_epi32(height);
+		const __m512i halfWidth = _mm512_set1_epi32(width / 2), halfHeight = _mm512_set1_epi32(height / 2);
+		const __m512i zero = _mm512_setzero_si512();
+
+		__m512i best[SIMD_NEAREST_MAX_TYPES], bestIndex[SIMD_NEAREST_MAX_TYPES], second[SIMD_NEAREST_MAX_TYPES];
+		for (int type = 0; type < numTypes; type++) {
+			best[type] = _mm512_set1_epi32(INT32_MAX);
+			bestIndex[type] = _mm512_set1_epi32(-1);
+			second[type] = _mm512_set1_epi32(INT32_MAX);
+		}
+
+		__m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		for (size_t block = 0; block < count; block += 16) {
+			const __m512 cx = _mm512_cvtepi32_ps(_mm512_cvttps_epi32(_mm512_loadu_ps(xs + block)));
+			const __m512 cy = _mm512_cvtepi32_ps(_mm512_cvttps_epi32(_mm512_loadu_ps(ys + block)));
+			__m512i distanceX = _mm512_cvttps_epi32(_mm512_abs_ps(_mm512_sub_ps(px, cx)));
+			__m512i distanceY = _mm512_cvttps_epi32(_mm512_abs_ps(_mm512_sub_ps(py, cy)));
+			distanceX = _mm512_mask_sub_epi32(distanceX, _mm512_cmpgt_epi32_mask(distanceX, halfWidth), worldWidth, distanceX);
+			distanceY = _mm512_mask_sub_epi32(distanceY, _mm512_cmpgt_epi32_mask(distanceY, halfHeight), worldHeight, distanceY);
+			__m512i distance = _mm512_add_epi32(_mm512_mullo_epi32(distanceX, distanceX), _mm512_mullo_epi32(distanceY, distanceY));
+			distance = _mm512_max_epi32(_mm512_sub_epi32(distance, _mm512_loadu_si512(radiusSquared + block)), zero);
+
+			const __m512i blockTypes = _mm512_loadu_si512(types + block);
+			for (int type = 0; type < numTypes; type++) {
+				const __mmask16 isType = _mm512_cmpeq_epi32_mask(blockTypes, _mm512_set1_epi32(type));
+				const __mmask16 nearer = isType & _mm512_cmpgt_epi32_mask(best[type], distance);
+				const __m512i runnerUp = _mm512_mask_mov_epi32(distance, nearer, best[type]);
+				second[type] = _mm512_mask_min_epi32(second[type], isType, second[type], runnerUp);
+				best[type] = _mm512_mask_mov_epi32(best[type], nearer, distance);
+				bestIndex[type] = _mm512_mask_mov_epi32(bestIndex[type], nearer, index);
+			}
+			index = _mm512_add_epi32(index, _mm512_set1_epi32(16));
+		}
+
+		int32_t laneIndex[16], laneDistance[16], laneSecond[16];
+		for (int type = 0; type < numTypes; type++) {
+			_mm512_storeu_si512(laneIndex, bestIndex[type]);
+			_mm512_storeu_si512(laneDistance, best[type]);
+			_mm512_storeu_si512(laneSecond, second[type]);
+			nearestFromLanes(laneIndex, laneDistance, laneSecond, 16, nearestIndex[type], nearestDistance[type], secondDistance[type]);
+		}
+	}
+#endif
+
+	// Returns the kernels for a specific instruction set
+	static Kernels kernelsFor(SimdLevel level) {
+		switch (level) {
+#ifdef SIMD_X86
+		case SimdLevel::slAVX512: return { level, dotRowsAVX512, dotRowsBatchAVX512, sigmoidAVX512, nearestAVX512, sinCosAVX512 };
+		case SimdLevel::slAVX2:   return { level, dotRowsAVX2, dotRowsBatchAVX2, sigmoidAVX2, nearestAVX2, sinCosAVX2 };
+#endif
+		default:                  return { SimdLevel::slScalar, dotRowsScalar, dotRowsBatchScalar, sigmoidScalar, nearestScalar, sinCosScalar };
+		}
+	}
+
+public:
+	// Sigmoid activation function
+	static float sigmoid(float input) {
+		return 1.0f / (1.0f + (float)pow(M_E, -input));
+	}
+
+	// Returns the best instruction set this CPU (and OS) supports
+	static SimdLevel detect() {
+#ifdef SIMD_X86
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return SimdLevel::slScalar;
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave) return SimdLevel::slScalar;
+		const unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		const bool avx2 = (info[1] & (1 << 5)) != 0;
+		const bool avx512 = (info[1] & (1 << 16)) != 0;
+		// The OS must save the YMM registers (and for AVX-512 the ZMM and mask registers too)
+		if (avx512 && ((xcr0 & 0xE6) == 0xE6)) return SimdLevel::slAVX512;
+		if (avx2 && fma && ((xcr0 & 0x6) == 0x6)) return SimdLevel::slAVX2;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f")) return SimdLevel::slAVX512;
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::slAVX2;
+#endif
+#endif
+		return SimdLevel::slScalar;
+	}
+
+	// Force a specific instruction set (eg. to compare against the scalar version).  Don't use one detect() didn't return
+	static void select(SimdLevel level) {
+		active() = kernelsFor(level);
+	}
+
+	// The instruction set currently in use
+	static SimdLevel level() {
+		return active().level;
+	}
+
+	// Calculates outputs[n] = dot(weights + (n * stride), inputs) for each of the numOutputs rows
+	static void dotRows(const float* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs) {
+		active().dotRows(weights, stride, inputs, numInputs, outputs, numOutputs);
+	}
+
+	// dotRows for a batch of count matrices that are the same shape.  Matrix m starts at weights[m], its inputs are at
+	// inputs + (m * numInputs) and its outputs go to outputs + (m * numOutputs)
+	static void dotRowsBatch(const float* const* weights, size_t stride, const float* inputs, size_t numInputs, float* outputs, size_t numOutputs, size_t count) {
+		active().dotRowsBatch(weights, stride, inputs, numInputs, outputs, numOutputs, count);
+	}
+
+	// Replaces each value with its sigmoid
+	static void sigmoid(float* values, size_t count) {
+		active().sigmoid(values, count);
+	}
+
+	// For each type (0 to numTypes-1), finds the resource nearest to (x, y) in a world that wraps at width and height.
+	// The distance is the squared distance in whole pixels less the resource's radius squared, as Simulation has always used.
+	// nearestIndex[type] is -1 if there are none of that type.  On a tie the lowest index wins.  secondDistance[type] is the
+	// distance to the next nearest of that type, or INT32_MAX if there's only one.  count must be a multiple
+	// of SIMD_NEAREST_PADDING, padding entries should have a type of -1.  Half the width squared plus half the height
+	// squared has to fit in an int32_t
+	static void nearest(const float* xs, const float* ys, const int32_t* radiusSquared, const int32_t* types, size_t count,
+		float x, float y, int32_t width, int32_t height, int numTypes, int32_t* nearestIndex, int32_t* nearestDistance, int32_t* secondDistance) {
+		active().nearest(xs, ys, radiusSquared, types, count, x, y, width, height, numTypes, nearestIndex, nearestDistance, secondDistance);
+	}
+
+	// Calculates the sine and cosine of count angles (in radians).  See SIMD_SINCOS_TOLERANCE for the accuracy
+	static void sinCos(const float* angles, float* sines, float* cosines, size_t count) {
+		active().sinCos(angles, sines, cosines, count);
+	}
+};
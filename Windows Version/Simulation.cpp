@@ -0,0 +1,21 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#include "Simulation.h"
+
+// Create a simulation of one of the experiments (MODE1 to MODE4).  Returns nullptr if there isn't one with that number
+Experiment* createExperiment(const int mode, const uint64_t seed, const WorldSettings& world) {
+	switch (mode) {
+		case MODE1: return new Simulation<ExperimentMode<MODE1>>(seed, world);
+		case MODE2: return new Simulation<ExperimentMode<MODE2>>(seed, world);
+		case MODE3: return new Simulation<ExperimentMode<MODE3>>(seed, world);
+		case MODE4: return new Simulation<ExperimentMode<MODE4>>(seed, world);
+		default: return nullptr;
+	}
+}
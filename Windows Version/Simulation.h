@@ -26,11 +26,9 @@
 #define MAX_TURN_SPEED					0.4f
 
 
-// Screen size
+// Screen size.  This is also the default size of the world, the headless runner can make it bigger (see WorldSettings)
 #define SIMULATION_WIDTH		600
 #define SIMULATION_HEIGHT		600
-#define SIMULATION_HALFWIDTH    (SIMULATION_WIDTH/2)
-#define SIMULATION_HALFHEIGHT    (SIMULATION_HEIGHT/2)
 
 #define MAX_CELLS				20
 #define POPULATION_SIZE			30 
@@ -54,67 +52,130 @@
 #define LOAD_GENERATION			0
 #endif
 
-// Experiment mode
+// Experiment mode the window runs, and the headless runner unless it's told otherwise.  What each one does is in ExperimentMode.h
 // 1. Looking for Batteries
 // 2. Looking for Solar Electricity and Batteries
 // 3. Batteries and Quicksand
 // 4. Batteries and Shields
 #define EXPERIMENT_MODE			MODE1
 
-#if EXPERIMENT_MODE == MODE1
-#define NOT_CONSUMABLE		ResourceType::rtNone
-#define MAX_FITNESS			3.0f		
-#endif
+// How the genetic algorithm picks parents. See GeneticAlgorithm.h
+#define PARENT_SELECTION		SelectionMethod::smPrefixSum
 
-#if EXPERIMENT_MODE == MODE2
-//#define USE_MULTIPLY_FUNCTION
-#define USE_SOLAR
-#define NOT_CONSUMABLE		ResourceType::rtSunlight
-#ifdef USE_MULTIPLY_FUNCTION
-#define MAX_FITNESS			3.0f
-#else
-#define MAX_FITNESS			4.0f
-#endif
-#endif
+// The activation function used by the brains. See Activation.h for the accuracy and speed of each
+#define NETWORK_ACTIVATION		ActivationFunction::afSigmoid
 
-#if EXPERIMENT_MODE == MODE3
-#define HAS_QUICKSAND
-#define NOT_CONSUMABLE		ResourceType::rtQuickSand
-#define MAX_FITNESS			3.0f
+// This is almost not worth doing with the small computations we're doing, the larger the brain, the more noticable this is
+#ifndef _DEBUG
+#define THREADDED
 #endif
 
-#if EXPERIMENT_MODE == MODE4
-#define NOT_CONSUMABLE		ResourceType::rtNone
-#define TRACK_OTHERS
-#define MAX_FITNESS			3.0f
-#undef MAX_CELLS
-#define MAX_CELLS			10
+// Number of threads to step the lifeforms with when THREADDED, 0 uses one per CPU core.  The headless runner can change it
+#define THREAD_COUNT			0
+
+// Number of lifeforms handed to a thread at a time.  Threads that finish early steal chunks from the others
+#define THREAD_CHUNK_SIZE		8
+
+// Rather than each lifeform updating its own brain, all of the brains are updated together in one batch each step.
+// Everyone looks around before anyone moves, so without DETERMINISTIC_STEPPING a battery used up early in a step can
+// still be seen by the lifeforms after it that step.  With DETERMINISTIC_STEPPING the results are the same either way
+#define BATCHED_BRAINS
+
+// Every lifeform moves against the world as it was at the start of the step, then who gets each resource is decided
+// in lifeform order.  Without this the threads race for resources and a run can't be repeated.  It plays out differently
+// to the original even with one thread (and in _DEBUG), as a battery eaten this step is still seen by everyone until
+// the step ends.  Turn it and BATCHED_BRAINS off to get the original behaviour back.  With THREADDED that also turns off
+// SIMD_RESOURCE_SCAN
+#define DETERMINISTIC_STEPPING
+
+// Keep the resources in a grid so finding them doesn't mean checking every one of them.  Needed for big worlds as without it
+// every lifeform checks every resource each step.  'ga1benchmark resources' times a lookup both ways, with the resources as far
+// apart as in the normal world the grid beats the SIMD scan from about 100 of them (3x at 1,000, 20x at 10,000)
+//#define SPATIAL_GRID
+
+// Smallest size of a grid cell in pixels.  In a big world with the resources spread thinly the cells are made bigger, so
+// there's about one resource per cell rather than millions of empty ones.  Resources too big to fit in one are kept to one
+// side and always checked
+#define GRID_CELL_SIZE			16
+
+// With several threads consuming resources at once the grid is brought up to date at the end of each step
+#if defined(SPATIAL_GRID) && defined(THREADDED) && !defined(DETERMINISTIC_STEPPING)
+#define DEFERRED_GRID_UPDATES
 #endif
 
+// Without the grid, find the nearest resources with SIMD over a copy of them laid out as arrays.  Gives the same answers
+#define SIMD_RESOURCE_SCAN
 
-#ifdef USE_SOLAR
-#ifdef HAS_QUICKSAND
-"This mode is unsupported. Please do not choose this combination!"
+// The SIMD scan can't cope with resources moving while it runs.  It doesn't know about shields either, so isn't used in MODE4
+#if defined(SIMD_RESOURCE_SCAN) && (defined(SPATIAL_GRID) || (defined(THREADDED) && !defined(DETERMINISTIC_STEPPING)))
+#undef SIMD_RESOURCE_SCAN
 #endif
+
+// Each lifeform remembers the nearest resources the SIMD scan found and how far away the next nearest were, and only
+// scans again once it might have moved far enough for them to change, or a resource has re-spawned near it.  MODE4 always
+// looks as the shields change what can be seen every step
+#define NEAREST_RESOURCE_CACHE
+
+// It needs the scan to say how far away the next nearest were
+#if defined(NEAREST_RESOURCE_CACHE) && !defined(SIMD_RESOURCE_SCAN)
+#undef NEAREST_RESOURCE_CACHE
 #endif
 
-// This is almost not worth doing with the small computations we're doing, the larger the brain, the more noticable this is
-#ifndef _DEBUG
-#define THREADDED
+// Smallest size of the blocks the world is cut into to keep track of where resources have re-spawned
+#define RESPAWN_BLOCK_SIZE		32
+
+// Keep a map of the free space so a random empty spot can be picked straight away, rather than trying spots until one is clear
+#define FREE_SPACE_SAMPLER
+
+// Size of the free space map's cells in pixels.  As with the grid they're made bigger in a big world with the resources spread thinly
+#define FREE_SPACE_CELL_SIZE	8
+
+// With several threads consuming resources at once the free space map is locked while one is moved
+#if defined(FREE_SPACE_SAMPLER) && defined(THREADDED) && !defined(DETERMINISTIC_STEPPING)
+#define LOCKED_FREE_SPACE
 #endif
 
+// Smallest size of a cell in the grid the lifeforms are put in each step so they can find each other (MODE4).  As with
+// the resource grid they're made bigger when the lifeforms are spread thinly
+#define NEIGHBOUR_CELL_SIZE		16
+
+// How far away a lifeform can see another after the same resource (MODE4).  The normal world wraps, so this sees right across it.
+// In a big world it stops them searching a long way for someone who's too far away to matter
+#define COMPETITOR_RANGE		425
+
+#include "Random.h"
 #include "NeuralNetwork.h"
 #include "GeneticAlgorithm.h"
 #include "LifeForm.h"
+#include "ExperimentMode.h"
+#include "Population.h"
+#include "NeighbourGrid.h"
 #include <vector>
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
 #include <thread>
-#include <mutex>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 
 #ifdef THREADDED
-#include <windows.h>
+#include "ThreadPool.h"
+#endif
+#ifdef SPATIAL_GRID
+#include "SpatialGrid.h"
+#endif
+#ifdef SIMD_RESOURCE_SCAN
+#include "ResourceTable.h"
+#endif
+#ifdef NEAREST_RESOURCE_CACHE
+#include "RespawnMap.h"
+#endif
+#ifdef FREE_SPACE_SAMPLER
+#include "FreeSpace.h"
+#endif
+#ifdef LOCKED_FREE_SPACE
+#include <mutex>
 #endif
 
 // Output Statistics
@@ -124,42 +185,515 @@ struct GenStatistics {
 	float totalFitness		= 0.0f;
 };
 
+// std::atomic that can be copied so it can be kept in a std::vector.  Only copy it while no other thread is using it
+template<typename T>
+struct CopyableAtomic : public std::atomic<T> {
+	CopyableAtomic(const T value = T()) : std::atomic<T>(value) {}
+	CopyableAtomic(const CopyableAtomic& other) : std::atomic<T>(other.load()) {}
+	CopyableAtomic& operator=(const CopyableAtomic& other) { this->store(other.load()); return *this; }
+	using std::atomic<T>::operator=;
+};
+
+// A position that can be read by one thread while another is changing it, as a resource's is (see Resource::version).
+// Each half is a relaxed atomic, which on x86 is an ordinary load or store
+struct SharedPosition {
+	CopyableAtomic<float> x, y;
+
+	operator FloatPair() const {
+		FloatPair position;
+		position.x = x.load(std::memory_order_relaxed);
+		position.y = y.load(std::memory_order_relaxed);
+		return position;
+	}
+	SharedPosition& operator=(const FloatPair& position) {
+		x.store(position.x, std::memory_order_relaxed);
+		y.store(position.y, std::memory_order_relaxed);
+		return *this;
+	}
+};
+
 // Details about resources available
 struct Resource {
 	ResourceType resourceType;
 
 	// Position and size
-	FloatPair position;
+	SharedPosition position;
 	int radius;
 	int radiusSquared;
 
-#ifdef TRACK_OTHERS
-	int shieldedBy = -1;
+	// Seqlock protecting the position.  It's odd while the resource is being moved, and goes up by two every time it re-spawns
+	CopyableAtomic<uint32_t> version;
+
+	CopyableAtomic<int> shieldedBy = -1;		// Lifeform that has its shield around it (MODE4)
+
+#ifdef SPATIAL_GRID
+	bool inGrid = false;						// FALSE if it's too big for a grid cell
+#ifdef DEFERRED_GRID_UPDATES
+	CopyableAtomic<bool> gridPending = false;	// It's moved since the grid was last updated
+#endif
 #endif
+
+	// Each resource picks where it re-spawns from its own stream, so it doesn't matter who consumed it
+	RandomStream random;
+};
+
+// How often threads got in each other's way over the resources
+struct ResourceContention {
+	uint64_t claims = 0;			// Resources consumed
+	uint64_t lostClaims = 0;		// Times a lifeform went to consume a resource and someone else had got there first
+	uint64_t movingReads = 0;		// Times a resource was skipped because it was in the middle of re-spawning
+};
+
+// The size of the world and how much is in it.  The defaults are the world the window shows
+struct WorldSettings {
+	int width = SIMULATION_WIDTH;
+	int height = SIMULATION_HEIGHT;
+	int populationSize = POPULATION_SIZE;
+	int numCells = 0;					// Batteries in the world.  0 uses the experiment's own number (see ExperimentMode.h)
+	int numThreads = THREAD_COUNT;		// Threads to step the lifeforms with when THREADDED, 0 uses one per CPU core
 };
 
 // Tracking each lifeform
+template<class Mode>
 struct LifeformData {
-	LifeForm* lifeForm;
+	LifeForm<Mode>* lifeForm;
 	NeuralNetwork* brain;
 };
 
-class Simulation {
+// What a runner needs from a simulation without knowing which experiment it is.  These are only called once a step
+// or less, everything inside a step is built separately for each experiment
+class Experiment {
+public:
+	virtual ~Experiment() {}
+
+	// Which experiment this is, MODE1 to MODE4
+	virtual int mode() const = 0;
+
+	// See Simulation
+	virtual bool step() = 0;
+	virtual void produceNextGeneration(GenStatistics& stats) = 0;
+	virtual int currentAge() const = 0;
+	virtual unsigned int generation() const = 0;
+	virtual uint64_t seed() const = 0;
+	virtual ResourceContention contention() const = 0;
+	virtual bool saveSnapshot(const std::wstring& filename, unsigned int generation, const GenStatistics& lastGeneration) = 0;
+	virtual bool loadSnapshot(const std::wstring& filename, unsigned int& generationLoaded, GenStatistics& lastGeneration) = 0;
+};
+
+// Create a simulation of one of the experiments (MODE1 to MODE4).  Returns nullptr if there isn't one with that number
+Experiment* createExperiment(const int mode, const uint64_t seed, const WorldSettings& world = WorldSettings());
+
+// The simulation of an experiment.  Mode is one of the ExperimentModes, see ExperimentMode.h
+template<class Mode>
+class Simulation : public Experiment {
 private:
+	static_assert(!(Mode::useSolar && Mode::hasQuickSand), "This mode is unsupported. Please do not choose this combination!");
+
+	int m_width, m_height;					// Size of the world in pixels
 	std::vector<Resource> m_resources;
-	std::vector<LifeformData> m_lifeForms;
+	std::vector<LifeformData<Mode>> m_lifeForms;
+	Population<Mode> m_population;			// Position, angle, age and resources of every lifeform
+	std::vector<size_t> m_activeLifeForms;	// The lifeforms still alive, in index order.  The dead are removed at the end of each step
 	GeneticAlgorithm m_geneticAlgorithm;
+	std::vector<NetworkWeightFitness> m_brains;
 	int m_ageCounter = 0;
+	uint64_t m_seed;					// All random numbers in the run come from streams made from this
+	unsigned int m_generation = 0;		// Current generation number
 
 #ifdef THREADDED
-	std::thread* m_thread1 = nullptr;
-	std::thread* m_thread2 = nullptr;
-	HANDLE m_thread1Start = 0;
-	HANDLE m_thread2Start = 0;
-	HANDLE m_thread1Finished = 0;
-	HANDLE m_thread2Finished = 0;
-	HANDLE m_terminate = 0;
-	std::recursive_mutex m_resourceLock;
+	ThreadPool m_threadPool;
+	ThreadPool::RangeFunction m_stepJob;	// Steps a chunk of lifeforms on one of the threads
+	std::vector<int> m_alive;				// Lifeforms still alive, counted by each thread
+#endif
+
+	// Contention counters.  These are only touched when a resource is consumed or moving, not on every lookup
+	std::atomic<uint64_t> m_claimCount;
+	std::atomic<uint64_t> m_lostClaimCount;
+	mutable std::atomic<uint64_t> m_movingReadCount;
+
+#ifdef SIMD_RESOURCE_SCAN
+	ResourceTable m_resourceTable;			// Copy of the resources for the SIMD scan
+	static constexpr bool m_useResourceTable = !Mode::trackOthers;	// The scan doesn't know about shields
+	const bool m_scanResources;				// Using the table.  Not in worlds too big for it (see ResourceTable::canScan)
+#endif
+
+#ifdef NEAREST_RESOURCE_CACHE
+	// The nearest resource of each type a lifeform found the last time it scanned them all
+	struct NearestCache {
+		FloatPair position;						// Where it looked from
+		uint64_t respawns = 0;					// m_respawns.count() before it looked
+		int index[NUM_RESOURCE_TYPES];			// Nearest of each type, or -1
+		uint32_t version[NUM_RESOURCE_TYPES];	// Its version, which changes if it's consumed
+		double reach[NUM_RESOURCE_TYPES];		// Distance to its centre
+		int32_t second[NUM_RESOURCE_TYPES];		// Distance to the next nearest the way the scan measures it (see SimdKernels::nearest())
+		bool valid = false;
+	};
+	std::vector<NearestCache> m_nearestCache;	// One for each lifeform.  Not used in MODE4
+	RespawnMap m_respawns;
+	int m_largestRadius[NUM_RESOURCE_TYPES] = {};	// Largest resource of each type
+	static constexpr double m_distanceSlack = 1.5;	// The whole pixel distances the scan uses can be out by up to sqrt(2)
+
+	// TRUE if the experiment looks for resources of this type
+	static constexpr bool isSensed(const int type) {
+		return (type == (int)ResourceType::rtCell) || ((type == (int)ResourceType::rtSunlight) && Mode::useSolar) ||
+			((type == (int)ResourceType::rtQuickSand) && Mode::hasQuickSand);
+	}
+
+	// TRUE if resources of this type can re-spawn.  The ones that can't be consumed never move
+	static constexpr bool canRespawn(const int type) {
+		return type != (int)Mode::notConsumable;
+	}
+
+	// Shortest distance between two points going round the world.  Resources are measured from the pixel their centre is in
+	double wrappedDistance(const FloatPair& from, const FloatPair& to) const {
+		double distanceX = std::abs((double)from.x - (double)to.x);
+		double distanceY = std::abs((double)from.y - (double)to.y);
+		if (distanceX > width() * 0.5) distanceX = width() - distanceX;
+		if (distanceY > height() * 0.5) distanceY = height() - distanceY;
+		return sqrt((distanceX * distanceX) + (distanceY * distanceY));
+	}
+
+	// Remember what the scan found from position
+	void fillNearestCache(const size_t lifeformIndex, const FloatPair& position, const uint64_t respawns, const int32_t* nearestIndex, const int32_t* secondDistance) {
+		if constexpr (!Mode::trackOthers) {
+			NearestCache& cache = m_nearestCache[lifeformIndex];
+			cache.position = position;
+			cache.respawns = respawns;
+			cache.valid = true;
+			for (int type = 0; type < NUM_RESOURCE_TYPES; type++) {
+				cache.index[type] = isSensed(type) ? nearestIndex[type] : -1;
+				cache.second[type] = secondDistance[type];
+				if (cache.index[type] < 0) continue;
+				FloatPair centre;
+				if (!readResource(cache.index[type], centre, cache.version[type])) {
+					cache.valid = false;
+					return;
+				}
+				cache.reach[type] = wrappedDistance(position, { (float)(int)centre.x, (float)(int)centre.y });
+			}
+		}
+	}
+
+	// Fill in the nearest resource of each type from the cache, if the lifeform can't have moved far enough for them to change
+	// and nothing has re-spawned near enough to matter.  Returns FALSE if they need finding again.
+	// The scan's distances are within the slack of the real ones.  Having moved d, the nearest (R away with a radius of r) can
+	// now be no further than (R+d+slack)^2-r^2.  The next nearest was s, so at best it was sqrt(s+rmax^2) away, and is
+	// now no nearer than (sqrt(s+rmax^2)-d-2*slack)^2-rmax^2, and the rest were further still
+	bool readNearestCache(const size_t lifeformIndex, const FloatPair& position, int* nearestIndex, FloatPair* centre) {
+		if constexpr (Mode::trackOthers) return false;
+		else {
+			const NearestCache& cache = m_nearestCache[lifeformIndex];
+			if (!cache.valid) return false;
+			const double moved = wrappedDistance(cache.position, position);
+
+			double danger = 0;		// Anything that's re-spawned closer than this might be nearer
+			for (int type = 0; type < NUM_RESOURCE_TYPES; type++) {
+				const int index = cache.index[type];
+				nearestIndex[type] = index;
+				if (!isSensed(type)) continue;
+				if (index < 0) {
+					// There wasn't one to be seen, so anything re-spawning could be the nearest
+					if (canRespawn(type) && (m_respawns.count() != cache.respawns)) return false;
+					continue;
+				}
+				uint32_t version;
+				if ((!readResource(index, centre[type], version)) || (version != cache.version[type])) return false;
+
+				const double largest = (double)m_largestRadius[type] * m_largestRadius[type];
+				const double furthest = cache.reach[type] + moved + m_distanceSlack;
+				const double toBeat = std::max(0.0, (furthest * furthest) - m_resources[index].radiusSquared);
+				const double closest = std::max(0.0, sqrt((double)cache.second[type] + largest) - moved - (m_distanceSlack * 2));
+				if ((closest * closest) - largest <= toBeat) return false;
+
+				// A new one would be measured from a centre up to another pixel away
+				if (canRespawn(type)) {
+					const double reach = sqrt(toBeat + largest) + (m_distanceSlack * 2);
+					if (reach > danger) danger = reach;
+				}
+			}
+			return !m_respawns.respawnedNear(position.x, position.y, (float)danger, cache.respawns);
+		}
+	}
+#endif
+
+	// Shields (MODE4).  Each lifeform has at most one, the resource's shieldedBy says who and this says which resource.
+	// Taking, moving and dropping a shield are a compare-exchange on each side
+	std::vector<CopyableAtomic<int>> m_shielding;	// The resource each lifeform has its shield around, or -1
+
+	// How many lifeforms are heading for each resource, offset by one so -1 is counted too (MODE4).  With DETERMINISTIC_STEPPING
+	// this is where they were heading at the start of the step, otherwise it changes as soon as a lifeform picks a new target
+	std::vector<CopyableAtomic<int>> m_targetCount;
+
+	// Where the living lifeforms were at the start of the step and the resource each was heading for, so each can find
+	// the nearest other lifeform after the same resource as it (MODE4)
+	NeighbourGrid m_neighbours;
+	std::vector<int> m_neighbourTarget;		// The resource each lifeform in m_neighbours was heading for
+	std::vector<int> m_competitorCount;		// How many in m_neighbours are heading for each resource, offset by one so -1 is counted too
+
+	// Rebuild m_neighbours, before anyone moves (MODE4)
+	void updateNeighbours() {
+		std::fill(m_competitorCount.begin(), m_competitorCount.end(), 0);
+		m_neighbours.clear();
+		for (const size_t index : m_activeLifeForms) {
+			// The same test as Population::drain(), so these are the ones that will be active this step
+			if (!m_population.isAlive(index)) continue;
+			const FloatPair position = m_population.position(index);
+			const int target = m_lifeForms[index].lifeForm->targetResource();
+			m_neighbours.add((int)index, position.x, position.y);
+			m_neighbourTarget[index] = target;
+			m_competitorCount[target + 1]++;
+		}
+		m_neighbours.build();
+	}
+
+	// A lifeform has changed which resource it's heading for (MODE4)
+	void retarget(const int from, const int to) {
+		m_targetCount[from + 1].fetch_sub(1, std::memory_order_relaxed);
+		m_targetCount[to + 1].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Nobody is heading for anything or has a shield up, as at the start of a generation (MODE4)
+	void resetTargets() {
+		for (Resource& r : m_resources) r.shieldedBy = -1;
+		for (CopyableAtomic<int>& shielding : m_shielding) shielding = -1;
+		std::fill(m_targetCount.begin(), m_targetCount.end(), 0);
+		m_targetCount[0] = (int)m_lifeForms.size();
+#ifdef DETERMINISTIC_STEPPING
+		std::fill(m_resourceTargets.begin(), m_resourceTargets.end(), -1);
+#endif
+	}
+
+#ifdef SPATIAL_GRID
+	int m_gridCellSize;						// Resources up to this size (less a bit) go in the grid
+	SpatialGrid m_grid;
+	std::vector<int> m_largeResources;		// Resources too big for the grid.  These are always checked
+	int m_gridRadius = 0;					// Largest radius of the resources in the grid
+	int m_gridTypeCount[NUM_RESOURCE_TYPES] = {};	// Number of resources of each type in the grid
+#ifdef DEFERRED_GRID_UPDATES
+	std::vector<int> m_gridPending;			// Resources that have moved this step
+	std::atomic<size_t> m_gridPendingCount;
+
+	// Move the resources consumed this step to their new grid cells
+	void updateGrid() {
+		const size_t count = m_gridPendingCount.exchange(0);
+		for (size_t pending = 0; pending < count; pending++) {
+			Resource& resource = m_resources[m_gridPending[pending]];
+			resource.gridPending = false;
+			m_grid.move(m_gridPending[pending], resource.position.x, resource.position.y);
+		}
+	}
+#endif
+#endif
+
+#ifdef FREE_SPACE_SAMPLER
+	FreeSpace m_freeSpace;					// Room left for resources and lifeforms.  Follows the resources as they move
+#ifdef LOCKED_FREE_SPACE
+	std::mutex m_freeSpaceLock;
+#endif
+#endif
+
+	// Read a resource's position.  Returns FALSE if it's being moved (ie. it's just been consumed and isn't really there).
+	// No lock is needed, if it moves while being read the version changes and it's treated as moving
+	bool readResource(const size_t index, FloatPair& position, uint32_t& version) const {
+		const Resource& resource = m_resources[index];
+		version = resource.version.load(std::memory_order_acquire);
+		if ((version & 1) == 0) {
+			position = resource.position;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (resource.version.load(std::memory_order_relaxed) == version) return true;
+		}
+		m_movingReadCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Consume a resource that was read at 'version' and re-spawn it somewhere else.  Only one thread can win this,
+	// returns FALSE if someone else consumed it first
+	bool claimResource(const size_t index, const uint32_t version) {
+		Resource& resource = m_resources[index];
+		uint32_t expected = version;
+		if (!resource.version.compare_exchange_strong(expected, version + 1, std::memory_order_acquire)) {
+			m_lostClaimCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		// Readers mustn't see the new position without the odd version in front of it
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// Re-spawn (well, just move it to a new position. But its the same idea)
+		FloatPair position;
+#ifdef FREE_SPACE_SAMPLER
+#ifdef LOCKED_FREE_SPACE
+		std::lock_guard<std::mutex> lock(m_freeSpaceLock);
+#endif
+		m_freeSpace.remove((int)index);
+#endif
+		getRandomPosition(position, resource.random, (int)index);
+		resource.position = position;
+#ifdef FREE_SPACE_SAMPLER
+		m_freeSpace.add((int)index, position.x, position.y, resource.radius);
+#endif
+		if constexpr (Mode::trackOthers) {
+			// The shield doesn't go with it
+			const int owner = resource.shieldedBy.exchange(-1);
+			int shielding = (int)index;
+			if (owner >= 0) m_shielding[owner].compare_exchange_strong(shielding, -1);
+		}
+#ifdef SIMD_RESOURCE_SCAN
+		if (m_scanResources) m_resourceTable.move(index, position.x, position.y);
+#endif
+#ifdef SPATIAL_GRID
+		if (resource.inGrid) {
+#ifdef DEFERRED_GRID_UPDATES
+			if (!resource.gridPending.exchange(true)) m_gridPending[m_gridPendingCount++] = (int)index;
+#else
+			m_grid.move((int)index, position.x, position.y);
+#endif
+		}
+#endif
+		resource.version.store(version + 2, std::memory_order_release);
+#ifdef NEAREST_RESOURCE_CACHE
+		m_respawns.respawned(position.x, position.y);
+#endif
+		m_claimCount.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+#ifdef BATCHED_BRAINS
+	// The lifeforms (and their brains) being updated in a batch.  One of these per thread
+	struct StepBatch {
+		std::vector<size_t> lifeForms;
+		std::vector<NeuralNetwork*> brains;
+		NeuralNetwork::Batch work;
+	};
+	std::vector<StepBatch> m_stepBatches;
+
+	// Step a list of lifeforms in three phases. All of them gather their inputs, then the brains are
+	// updated in one batch, then the outputs are applied.  Returns the number still alive
+	int stepBatch(const size_t* lifeForms, const size_t count, StepBatch& batch) {
+		batch.lifeForms.clear();
+		batch.brains.clear();
+
+		// Phase 1: Sense.  Resources are used up in one pass over the list, then the living ones look around
+		m_population.drain(lifeForms, count);
+		for (size_t position = 0; position < count; position++) {
+			const size_t index = lifeForms[position];
+			if (m_population.isActive(index)) {
+				m_lifeForms[index].lifeForm->look();
+				batch.lifeForms.push_back(index);
+				batch.brains.push_back(m_lifeForms[index].brain);
+			}
+		}
+
+		// Phase 2: Think
+		NeuralNetwork::updateBatch(batch.brains.data(), batch.brains.size(), batch.work);
+
+		// Phase 3: Act.  Everyone moves in one pass, then deals with whatever they landed on
+		for (size_t index : batch.lifeForms)
+			m_population.setOutputs(index, m_lifeForms[index].brain->value(0), m_lifeForms[index].brain->value(1));
+		m_population.move(lifeForms, count);
+		int lifeforms = 0;
+		for (size_t index : batch.lifeForms)
+			if (land(index)) lifeforms++;
+		return lifeforms;
+	}
+#endif
+
+	// Step a single lifeform.  Returns TRUE if it's still alive
+	bool stepLifeForm(const size_t index) {
+		if (!m_lifeForms[index].lifeForm->sense()) return false;
+		NeuralNetwork* brain = m_lifeForms[index].brain;
+		brain->update();
+		m_population.setOutputs(index, brain->value(0), brain->value(1));
+		m_population.move(index, index + 1);
+		return land(index);
+	}
+
+	// Deal with what a lifeform landed on after moving.  Returns TRUE if it's still alive
+	bool land(const size_t index) {
+		LifeForm<Mode>* lifeForm = m_lifeForms[index].lifeForm;
+#ifdef DETERMINISTIC_STEPPING
+		// Just note what we landed on, resolveStep() decides who actually gets it
+		m_claims[index] = resourceIndexAtPosition(lifeForm->position(), -1, (int)index);
+		return true;
+#else
+		if constexpr (Mode::trackOthers) lifeForm->useShield();
+		// The last parameter says we want to 'consume' it
+		return lifeForm->land(resourceTypeAtPosition(lifeForm->position(), true, -1, (int)index));
+#endif
+	}
+
+#ifdef DETERMINISTIC_STEPPING
+	// What each lifeform landed on this step, worked out (in parallel) against the world as it was at the start of the step
+	std::vector<int> m_claims;				// Index of the resource each lifeform landed on, or -1
+	std::vector<int> m_claimWinner;			// For each resource, the lifeform that gets to consume it this step, or -1
+	std::vector<int> m_claimed;				// The resources that have a winner this step
+	std::vector<int> m_resourceTargets;		// The resource each lifeform was heading for at the start of the step (MODE4)
+
+	// Squared distance from a lifeform to the centre of the resource it landed on
+	float claimDistance(const size_t index) const {
+		const FloatPair position = m_lifeForms[index].lifeForm->position();
+		const FloatPair centre = m_resources[m_claims[index]].position;
+		return ((position.x - centre.x) * (position.x - centre.x)) + ((position.y - centre.y) * (position.y - centre.y));
+	}
+
+	// Second half of a step, run on one thread.  Shields go up in lifeform order, then each resource goes to the
+	// nearest lifeform that landed on it (the lowest index on a tie) and is re-spawned.  Returns the number still alive
+	int resolveStep() {
+		if constexpr (Mode::trackOthers) {
+			for (size_t index : m_activeLifeForms)
+				if (m_population.isActive(index)) m_lifeForms[index].lifeForm->useShield();
+		}
+
+		// Pick who gets each resource
+		for (size_t index : m_activeLifeForms) {
+			int& claim = m_claims[index];
+			if ((!m_population.isActive(index)) || (claim < 0)) continue;
+			if constexpr (Mode::trackOthers) {
+				// Someone may have shielded it since
+				const int shieldedBy = m_resources[claim].shieldedBy;
+				if ((shieldedBy >= 0) && (shieldedBy != (int)index)) {
+					claim = -1;
+					continue;
+				}
+			}
+			if (m_resources[claim].resourceType == Mode::notConsumable) continue;
+			int& winner = m_claimWinner[claim];
+			if (winner < 0) m_claimed.push_back(claim);
+			if ((winner < 0) || (claimDistance(index) < claimDistance(winner))) winner = (int)index;
+		}
+
+		// Hand them out
+		int lifeforms = 0;
+		for (size_t index : m_activeLifeForms) {
+			if (!m_population.isActive(index)) continue;
+			const int claim = m_claims[index];
+			ResourceType found = ResourceType::rtNone;
+			if (claim >= 0) {
+				const ResourceType type = m_resources[claim].resourceType;
+				if ((type == Mode::notConsumable) || (m_claimWinner[claim] == (int)index)) found = type;
+			}
+			if (m_lifeForms[index].lifeForm->land(found)) lifeforms++;
+		}
+
+		// Re-spawn the ones that were consumed.  Where each goes depends on where the others are, so it's done in resource order
+		std::sort(m_claimed.begin(), m_claimed.end());
+		for (const int index : m_claimed) {
+			respawnResource(index);
+			m_claimWinner[index] = -1;
+		}
+		m_claimed.clear();
+
+		if constexpr (Mode::trackOthers) {
+			// The dead don't change target any more
+			for (size_t index : m_activeLifeForms) {
+				int& target = m_resourceTargets[index];
+				const int newTarget = m_lifeForms[index].lifeForm->targetResource();
+				if (newTarget == target) continue;
+				retarget(target, newTarget);
+				target = newTarget;
+			}
+		}
+		return lifeforms;
+	}
 #endif
 
 	// Calculate the vlaues required to locate the coordinates (target) in the variable passed
@@ -171,22 +705,22 @@ private:
 			return;
 		}
 
-		// If it takes more than half the width its quicker to go the other direction
-		int movementX = (int)(position.x - resource.target.x);
-		if (abs(movementX) > halfWidth()) {
+		// If it takes more than half the width its quicker to go the other direction.  64 bits so big worlds don't overflow when squared
+		int64_t movementX = (int64_t)(position.x - resource.target.x);
+		if (std::abs(movementX) > halfWidth()) {
 			resource.target.x = (movementX > 0) ? (resource.target.x + width()) : (resource.target.x - width());
-			movementX = (int)(position.x - resource.target.x);
+			movementX = (int64_t)(position.x - resource.target.x);
 		}
 
 		// Repeat for the 'y' direction
-		int movementY = (int)(position.y - resource.target.y);
-		if (abs(movementY) > halfHeight()) {
+		int64_t movementY = (int64_t)(position.y - resource.target.y);
+		if (std::abs(movementY) > halfHeight()) {
 			resource.target.y = (movementY > 0) ? (resource.target.y + height()) : (resource.target.y - height());
-			movementY = (int)(position.y - resource.target.y);
+			movementY = (int64_t)(position.y - resource.target.y);
 		}
 
 		// Calculate direction required
-		float length = (float)sqrt((movementX * movementX) + (movementY * movementY));
+		float length = (float)sqrt((double)((movementX * movementX) + (movementY * movementY)));
 		if (length < 0.1f) length = 0.1f;
 		resource.direction.x = -(float)movementX / length;
 		resource.direction.y = -(float)movementY / length;
@@ -199,222 +733,323 @@ private:
 		r.radius = radius;
 		r.radiusSquared = radius * radius;
 		r.resourceType = rt;
+		r.random.reset(m_seed, RandomPurpose::rpWorld, m_resources.size() + 1);
+#ifdef SPATIAL_GRID
+		// The grid only needs to look in the cells next to a point if everything in it fits inside a cell
+		r.inGrid = (radius + 2) <= m_gridCellSize;
+		if (r.inGrid) {
+			m_grid.insert((int)m_resources.size(), position.x, position.y);
+			if (radius > m_gridRadius) m_gridRadius = radius;
+			m_gridTypeCount[(int)rt]++;
+		}
+		else m_largeResources.push_back((int)m_resources.size());
+#endif
+#ifdef FREE_SPACE_SAMPLER
+		m_freeSpace.add((int)m_resources.size(), position.x, position.y, radius);
+#endif
 		m_resources.push_back(r);
+#ifdef NEAREST_RESOURCE_CACHE
+		if (radius > m_largestRadius[(int)rt]) m_largestRadius[(int)rt] = radius;
+#endif
+#ifdef SIMD_RESOURCE_SCAN
+		if (m_scanResources) m_resourceTable.add(position.x, position.y, r.radiusSquared, (int)rt);
+#endif
+#ifdef DEFERRED_GRID_UPDATES
+		m_gridPending.push_back(0);
+#endif
+	}
+
+	// Snapshots start with this, then the shape of the brains.  Older ones started straight away with the generation number
+	static constexpr uint32_t m_snapshotTag = 0x31414753;		// "SGA1"
+
+	// Open a snapshot file.  Only Visual Studio's fstream takes a wide filename, elsewhere the name must be plain ASCII
+	static std::fstream openSnapshot(const std::wstring& filename, const std::ios_base::openmode mode) {
+#ifdef _MSC_VER
+		return std::fstream(filename, mode);
+#else
+		return std::fstream(std::string(filename.begin(), filename.end()), mode);
+#endif
+	}
+
+	// Cells of minimumSize, or bigger if that would make lots more cells than there are resources.  For the grid and free space map
+	static int cellSize(const WorldSettings& world, const int numResources, const int minimumSize) {
+		const int smallest = world.width < world.height ? world.width : world.height;
+		const double spacing = sqrt(((double)world.width * (double)world.height) / (numResources > 0 ? numResources : 1));
+		if (spacing <= minimumSize) return minimumSize;
+		return spacing < smallest ? (int)spacing : smallest;
 	}
 
 public:
 
-	// Prepare the simulation with the resources
-	Simulation() : m_geneticAlgorithm(NUM_ALPHAS, 0.7f, 0.1f, 0.3f) {	
-		int size = width() < height() ? width() : height();
+	// The layer sizes of every lifeform's brain in this experiment
+	static std::vector<size_t> brainLayers() {
+		std::vector<size_t> layers = Mode::networkLayers();
+#ifdef LARGER_BRAIN
+		// More hidden layers *can* increase intellegence
+		layers.insert(layers.begin() + 3, 8);
+#endif
+		return layers;
+	}
 
-#ifdef USE_SOLAR
-		// Add two spots of sunlight
-		addResource({ 0.3f * width(), 0.2f * height() }, (int)(0.1f * size), ResourceType::rtSunlight);
-		addResource({ 0.9f * width(), 0.9f * height() }, (int)(0.2f * size), ResourceType::rtSunlight);
+	// Prepare the simulation with the resources.  The same seed will always produce the same run
+	Simulation(const uint64_t seed, const WorldSettings& world = WorldSettings()) : m_width(world.width), m_height(world.height),
+		m_population(world.width, world.height), m_geneticAlgorithm(NUM_ALPHAS, 0.7f, 0.1f, 0.3f, PARENT_SELECTION), m_seed(seed)
+#ifdef THREADDED
+		, m_threadPool(world.numThreads)
+#endif
+		, m_claimCount(0), m_lostClaimCount(0), m_movingReadCount(0)
+#ifdef SIMD_RESOURCE_SCAN
+		, m_scanResources(m_useResourceTable && ResourceTable::canScan(world.width, world.height))
 #endif
-#ifdef HAS_QUICKSAND
-		// Add some quicksand on the map, one smack bang in the middle
-		addResource({ 0.5f * width(), 0.3f * height() }, (int)(0.15f * size), ResourceType::rtQuickSand);
-		addResource({ 0.5f * width(), 0.5f * height() }, (int)(0.15f * size), ResourceType::rtQuickSand);
-		addResource({ 0.5f * width(), 0.7f * height() }, (int)(0.15f * size), ResourceType::rtQuickSand);
+#ifdef NEAREST_RESOURCE_CACHE
+		, m_respawns(world.width, world.height, cellSize(world, world.numCells > 0 ? world.numCells : Mode::numCells, RESPAWN_BLOCK_SIZE))
 #endif
+		, m_neighbours(world.width, world.height, cellSize(world, world.populationSize, NEIGHBOUR_CELL_SIZE))
+#ifdef SPATIAL_GRID
+		, m_gridCellSize(cellSize(world, world.numCells > 0 ? world.numCells : Mode::numCells, GRID_CELL_SIZE))
+		, m_grid(world.width, world.height, m_gridCellSize)
+#ifdef DEFERRED_GRID_UPDATES
+		, m_gridPendingCount(0)
+#endif
+#endif
+#ifdef FREE_SPACE_SAMPLER
+		, m_freeSpace(world.width * 0.1f, world.height * 0.1f, world.width * 0.8f, world.height * 0.8f,
+			cellSize(world, world.numCells > 0 ? world.numCells : Mode::numCells, FREE_SPACE_CELL_SIZE))
+#endif
+	{	
+		int size = width() < height() ? width() : height();
+		m_geneticAlgorithm.setSeed(seed);
 
-		// Add some oil drops
-		for (int counter = 0; counter < MAX_CELLS; counter++) {
+		if constexpr (Mode::useSolar) {
+			// Add two spots of sunlight
+			addResource({ 0.3f * width(), 0.2f * height() }, (int)(0.1f * size), ResourceType::rtSunlight);
+			addResource({ 0.9f * width(), 0.9f * height() }, (int)(0.2f * size), ResourceType::rtSunlight);
+		}
+		if constexpr (Mode::hasQuickSand) {
+			// Add some quicksand on the map, one smack bang in the middle
+			addResource({ 0.5f * width(), 0.3f * height() }, (int)(0.15f * size), ResourceType::rtQuickSand);
+			addResource({ 0.5f * width(), 0.5f * height() }, (int)(0.15f * size), ResourceType::rtQuickSand);
+			addResource({ 0.5f * width(), 0.7f * height() }, (int)(0.15f * size), ResourceType::rtQuickSand);
+		}
+
+		// Add some oil drops.  They're the same size whatever size the world is, a bigger world just has more room
+		const int screenSize = SIMULATION_WIDTH < SIMULATION_HEIGHT ? SIMULATION_WIDTH : SIMULATION_HEIGHT;
+		const int numCells = world.numCells > 0 ? world.numCells : Mode::numCells;
+		m_resources.reserve(m_resources.size() + numCells);
+		RandomStream random(m_seed, RandomPurpose::rpWorld);
+		for (int counter = 0; counter < numCells; counter++) {
 			FloatPair pos;
-			getRandomPosition(pos);			
-			addResource(pos, (int)(0.012f * size), ResourceType::rtCell);
+			getRandomPosition(pos, random);
+			addResource(pos, (int)(0.012f * screenSize), ResourceType::rtCell);
 		}
 
 		// Finally create some lifeforms
-		for (int counter = 0; counter < POPULATION_SIZE; counter++) {
-			LifeformData data;
-			std::vector<size_t> networkLayers;
-#if EXPERIMENT_MODE == MODE1
-			networkLayers = { 5, 14, 12, 2 };
-#endif
-#if EXPERIMENT_MODE == MODE2
-			networkLayers = { 8, 14, 12, 2 };
+		m_population.resize(world.populationSize);
+		m_lifeForms.reserve(world.populationSize);
+		for (int counter = 0; counter < world.populationSize; counter++) {
+			LifeformData<Mode> data;
+			data.brain = new NeuralNetwork(brainLayers(), NETWORK_ACTIVATION);
+			data.lifeForm = new LifeForm<Mode>(data.brain, this, counter);
+			m_lifeForms.push_back(data);
+		}
+		m_brains.reserve(m_lifeForms.size());
+
+#ifdef BATCHED_BRAINS
+#ifdef THREADDED
+		m_stepBatches.resize(m_threadPool.numWorkers());
+#else
+		m_stepBatches.resize(1);
 #endif
-#if EXPERIMENT_MODE == MODE3
-			networkLayers = { 8, 14, 12, 2 };
+		for (StepBatch& batch : m_stepBatches) {
+			batch.lifeForms.reserve(m_lifeForms.size());
+			batch.brains.reserve(m_lifeForms.size());
+		}
 #endif
-#if EXPERIMENT_MODE == MODE4
-			networkLayers = { 7, 16, 14, 10, 4 };
+
+#ifdef NEAREST_RESOURCE_CACHE
+		if constexpr (!Mode::trackOthers) m_nearestCache.resize(m_lifeForms.size());
 #endif
-#ifdef LARGER_BRAIN
-			// More hidden layers *can* increase intellegence
-			networkLayers.insert(networkLayers.begin() + 3, 8);
+#ifdef DETERMINISTIC_STEPPING
+		m_claims.assign(m_lifeForms.size(), -1);
+		m_claimWinner.assign(m_resources.size(), -1);
+		m_claimed.reserve(m_resources.size());
+		if constexpr (Mode::trackOthers) m_resourceTargets.assign(m_lifeForms.size(), -1);
 #endif
-			data.brain = new NeuralNetwork(networkLayers);
-			data.lifeForm = new LifeForm(data.brain, this, counter);
-			m_lifeForms.push_back(data);
+		if constexpr (Mode::trackOthers) {
+			m_shielding.resize(m_lifeForms.size());
+			m_targetCount.resize(m_resources.size() + 1);
+			m_neighbourTarget.resize(m_lifeForms.size(), -1);
+			m_competitorCount.resize(m_resources.size() + 1);
+			resetTargets();
 		}
 
+		resetActiveLifeForms();
+
 #ifdef THREADDED
-		m_thread1Start = CreateEvent(NULL, TRUE, FALSE, NULL);
-		m_thread2Start = CreateEvent(NULL, TRUE, FALSE, NULL);
-		m_thread1Finished = CreateEvent(NULL, TRUE, FALSE, NULL);
-		m_thread2Finished = CreateEvent(NULL, TRUE, FALSE, NULL);
-		m_terminate = CreateEvent(NULL, TRUE, FALSE, NULL);
-		size_t midPoint = POPULATION_SIZE / 2;
-		
-		m_thread1 = new std::thread([this, midPoint]() {
-			SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
-			HANDLE events[2] = { m_thread1Start, m_terminate };
-			for (;;) {
-				DWORD result = WaitForMultipleObjects(2, events, FALSE, INFINITE);
-				if (result == WAIT_OBJECT_0 + 1) return;
-				ResetEvent(m_thread1Start);
-
-				for (size_t index = 0; index < midPoint; index++)
-					m_lifeForms[index].lifeForm->step();
-
-				SetEvent(m_thread1Finished);
-			}
-		});
-		m_thread2 = new std::thread([this, midPoint]() {
-			SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
-			HANDLE events[2] = { m_thread2Start, m_terminate };
-			for (;;) {
-				DWORD result = WaitForMultipleObjects(2, events, FALSE, INFINITE);
-				if (result == WAIT_OBJECT_0 + 1) return;
-				ResetEvent(m_thread2Start);
-
-				for (size_t index = midPoint; index < m_lifeForms.size(); index++)
-					m_lifeForms[index].lifeForm->step();
-
-				SetEvent(m_thread2Finished);
-			}
-		});
+		// The threads share out the active list rather than all of the lifeforms
+		m_alive.resize(m_threadPool.numWorkers());
+		m_stepJob = [this](size_t first, size_t last, size_t worker) {
+#ifdef BATCHED_BRAINS
+			m_alive[worker] += stepBatch(m_activeLifeForms.data() + first, last - first, m_stepBatches[worker]);
+#else
+			for (size_t position = first; position < last; position++)
+				if (stepLifeForm(m_activeLifeForms[position])) m_alive[worker]++;
+#endif
+		};
 #endif
 	}
 
 	// Free
-	~Simulation() {
-#ifdef THREADDED
-		SetEvent(m_terminate);
-		if (m_thread1) {
-			if (m_thread1->joinable()) m_thread1->join();
-			delete m_thread1;
-		}
-		if (m_thread2) {
-			if (m_thread2->joinable()) m_thread2->join();
-			delete m_thread2;
-		}
-		CloseHandle(m_thread1Finished);
-		CloseHandle(m_thread1Start);
-		CloseHandle(m_thread2Finished);
-		CloseHandle(m_thread2Start);
-#endif
-		for (LifeformData& data : m_lifeForms) {
+	~Simulation() override {
+		for (LifeformData<Mode>& data : m_lifeForms) {
 			delete data.brain;
 			delete data.lifeForm;
 		}
 	}
 
+	// Which experiment this is
+	int mode() const override {
+		return Mode::number;
+	}
+
 	// Advance the simulation one place
-	bool step() {
+	bool step() override {
 		int lifeforms = 0;
+		if constexpr (Mode::trackOthers) updateNeighbours();
 #ifdef THREADDED
-		// Trigger start
-		ResetEvent(m_thread1Finished);
-		ResetEvent(m_thread2Finished);
-		SetEvent(m_thread1Start);
-		SetEvent(m_thread2Start);
-
-		HANDLE threadWait[2] = {m_thread1Finished, m_thread2Finished};
-
-		// Wait for completion
-		WaitForMultipleObjects(2, threadWait, TRUE, INFINITE);
+		// Share the living lifeforms out between the threads and wait for them all to finish
+		std::fill(m_alive.begin(), m_alive.end(), 0);
+		m_threadPool.parallelFor(m_activeLifeForms.size(), THREAD_CHUNK_SIZE, m_stepJob);
 
 		// Count survivers
-		for (LifeformData& data : m_lifeForms)
-			if (data.lifeForm->isAlive()) lifeforms++;
+		for (int alive : m_alive) lifeforms += alive;
+#ifdef DEFERRED_GRID_UPDATES
+		updateGrid();
+#endif
+#else
+#ifdef BATCHED_BRAINS
+		lifeforms = stepBatch(m_activeLifeForms.data(), m_activeLifeForms.size(), m_stepBatches[0]);
 #else
 
-		for (LifeformData& data : m_lifeForms) {
-			if (data.lifeForm->step()) lifeforms++;
+		for (size_t index : m_activeLifeForms) {
+			if (stepLifeForm(index)) lifeforms++;
 		}
-
 #endif
+#endif
+#ifdef DETERMINISTIC_STEPPING
+		lifeforms = resolveStep();
+#endif
+		// Take out the ones that died, so they cost nothing from now on.  land() doesn't always report a death, so check them all
+		m_activeLifeForms.erase(std::remove_if(m_activeLifeForms.begin(), m_activeLifeForms.end(),
+			[this](size_t index) { return !m_population.isAlive(index); }), m_activeLifeForms.end());
+
 		m_ageCounter++;
 		return (lifeforms > 0) && (m_ageCounter< MAX_LIFESPAN);
 	}
 
-#ifdef TRACK_OTHERS
-	// Finds another competitor after the same resource you are and sets up the direction to them
-	bool isResourceTargettedByAnother(LifeForm* requester, int resourceIndex) {
-		for (const LifeformData& lifeform : m_lifeForms) 
-			if ((lifeform.lifeForm != requester) && (lifeform.lifeForm->isTargetingResource(resourceIndex))) {				
-				return true;
-			}
-		return false;
+	// Every lifeform starts a generation alive
+	void resetActiveLifeForms() {
+		m_activeLifeForms.resize(m_lifeForms.size());
+		for (size_t index = 0; index < m_lifeForms.size(); index++) m_activeLifeForms[index] = index;
 	}
 
-	// Attempt to put a shield around a resource
-	bool shieldResource(int resourceIndex, int lifeformIndex) {
-		bool found = false;
-#ifdef THREADDED
-		m_resourceLock.lock();
+	// Number of lifeforms still alive
+	int aliveCount() const {
+		return (int)m_activeLifeForms.size();
+	}
+
+	// Returns TRUE if another lifeform is after the same resource as the requester (MODE4)
+	bool isResourceTargettedByAnother(int requesterIndex, int resourceIndex) {
+		// Counted once for each lifeform heading for it, so leave ourselves out
+#ifdef DETERMINISTIC_STEPPING
+		// Everyone is updating at once, so use where they were all heading at the start of the step
+		const int ours = (m_resourceTargets[requesterIndex] == resourceIndex) ? 1 : 0;
+#else
+		const int ours = m_lifeForms[requesterIndex].lifeForm->isTargetingResource(resourceIndex) ? 1 : 0;
 #endif
-		for (size_t index=0; index< m_resources.size(); index++)
-			if ((m_resources[index].shieldedBy == lifeformIndex) || ((m_resources[index].shieldedBy == -1) && (index == resourceIndex))) {
-				if (resourceIndex == index) {
-					m_resources[index].shieldedBy = lifeformIndex;
-					found = true;
-				}
-				else m_resources[index].shieldedBy = -1;
+		return m_targetCount[resourceIndex + 1].load(std::memory_order_relaxed) > ours;
+	}
+
+	// Finds the nearest other living lifeform after the same resource as the requester and sets up the direction to them (MODE4).
+	// Everyone is as they were at the start of the step.  Returns FALSE if there's nobody else within COMPETITOR_RANGE
+	bool findCompetitor(int requesterIndex, const FloatPair& position, int resourceIndex, ResourceTarget& competitor) {
+		competitor.available = false;
+		if (resourceIndex >= 0) {
+			// Only look if there's someone to find, so it doesn't search the whole world for nobody
+			const int ours = (m_neighbourTarget[requesterIndex] == resourceIndex) ? 1 : 0;
+			if (m_competitorCount[resourceIndex + 1] > ours) {
+				auto isCompetitor = [&](const int index) { return (index != requesterIndex) && (m_neighbourTarget[index] == resourceIndex); };
+				competitor.available = m_neighbours.nearest(position.x, position.y, COMPETITOR_RANGE, isCompetitor, competitor.target.x, competitor.target.y) >= 0;
 			}
-#ifdef THREADDED
-		m_resourceLock.unlock();
-#endif
-		return found;
+		}
+		calculateBrainDestination(position, competitor);
+		return competitor.available;
 	}
 
-	// Release shield
+	// Attempt to put a shield around a resource (MODE4).  A lifeform only has one shield, so it moves from anything else it was around
+	bool shieldResource(int resourceIndex, int lifeformIndex) {
+		if (m_shielding[lifeformIndex].load(std::memory_order_relaxed) != resourceIndex) releaseShield(lifeformIndex);
+		if (resourceIndex < 0) return false;
+
+		// Take it if nobody else has
+		int unshielded = -1;
+		if (!m_resources[resourceIndex].shieldedBy.compare_exchange_strong(unshielded, lifeformIndex) && (unshielded != lifeformIndex)) return false;
+		m_shielding[lifeformIndex].store(resourceIndex, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Release shield (MODE4).  Only clears the resource's side if it's still ours, it may have re-spawned since
 	void releaseShield(int lifeformIndex) {
-		for (size_t index = 0; index < m_resources.size(); index++)
-			if (m_resources[index].shieldedBy == lifeformIndex) {
-				m_resources[index].shieldedBy = -1;
-			}
+		const int shielding = m_shielding[lifeformIndex].exchange(-1, std::memory_order_relaxed);
+		if (shielding < 0) return;
+		int shieldedBy = lifeformIndex;
+		m_resources[shielding].shieldedBy.compare_exchange_strong(shieldedBy, -1);
 	}
-#endif
 
 	// Get the pixel width of the simulation
 	int width() const {
-		return SIMULATION_WIDTH;
+		return m_width;
 	}
 
 	// Get the pixel height of the simulation
 	int height() const {
-		return SIMULATION_HEIGHT;
+		return m_height;
+	}
+
+	// State of all of the lifeforms
+	Population<Mode>& population() {
+		return m_population;
+	}
+
+	// Number of lifeforms in each generation
+	int populationSize() const {
+		return (int)m_lifeForms.size();
 	}
 
 	// Get the pixel width of the simulation
 	int halfWidth() const {
-		return SIMULATION_HALFWIDTH;
+		return m_width / 2;
 	}
 
 	// Get the pixel height of the simulation
 	int halfHeight() const {
-		return SIMULATION_HALFHEIGHT;
+		return m_height / 2;
 	}
 
 	// Instructs the next generation to be made.  Returns the number of survivors from the current gneration
 	// stats is information about the current generation
-	void produceNextGeneration(GenStatistics& stats) {
+	void produceNextGeneration(GenStatistics& stats) override {
 		stats.numSurvivors = 0;
 		stats.numIterations = m_ageCounter;
 		stats.totalFitness = 0;
 		
 		// Step 1: Extract the brains from our lifeforms
-		std::vector< NetworkWeightFitness > brains;
+		std::vector< NetworkWeightFitness >& brains = m_brains;
+		brains.clear();
 
-		for (LifeformData& data : m_lifeForms) {
+		stats.numSurvivors = aliveCount();
+		for (LifeformData<Mode>& data : m_lifeForms) {
 			data.lifeForm->calculateFitness();
-			if (data.lifeForm->isAlive()) stats.numSurvivors++;
 
 			NetworkWeightFitness brain;
 			brain.network = data.brain;
@@ -425,164 +1060,303 @@ public:
 
 		// Step 2: Pass into the Genetic Algorithm
 		m_geneticAlgorithm.produceNextGeneration(brains);
+		m_generation++;
 
 		// Step 3: Re-program the brains and reset them
-		for (LifeformData& data : m_lifeForms)
+		for (LifeformData<Mode>& data : m_lifeForms)
 			data.lifeForm->resetAge();
+		resetActiveLifeForms();
 
 		// Step 4: Reset
 		m_ageCounter = 0;
 
 		// Step 5: Reset shields
-#ifdef TRACK_OTHERS
-		for (Resource& r : m_resources) r.shieldedBy = -1;
-#endif
+		if constexpr (Mode::trackOthers) resetTargets();
 	}
 
 	// Get the current age of the simulation
-	int currentAge() const {
+	int currentAge() const override {
 		return m_ageCounter;
 	}
 
-	// Return what resource was found at a specific coordinate
-	ResourceType resourceTypeAtPosition(const FloatPair& position, bool consumeResource, int indexToIgnore = -1, int mustBelongTo = -1) {
-		// Iterate
-#ifdef THREADDED
-		m_resourceLock.lock();
-#endif
-		for (size_t index = 0; index < m_resources.size(); index++) {
-			if (index == indexToIgnore) continue;
-			// Skip a resource if its shielded by another lifeform
-#ifdef TRACK_OTHERS
-			if ((m_resources[index].shieldedBy >= 0) && (m_resources[index].shieldedBy != mustBelongTo) && (mustBelongTo >= 0)) continue;
-#endif
-			// Calculate the distance away
-			int distanceX = (int)(position.x - m_resources[index].position.x);
-			int distanceY = (int)(position.y - m_resources[index].position.y);
+	// The seed this run was started with
+	uint64_t seed() const override {
+		return m_seed;
+	}
 
-			// Use everything squared rather than calling sqrt which isnt the fastest thing in the world
-			if (sqrt((distanceX * distanceX) + (distanceY * distanceY)) <= m_resources[index].radius) {
-				if (consumeResource && (m_resources[index].resourceType != NOT_CONSUMABLE)) {
-					// Re-spawn (well, just move it to a new position. But its the same idea)
-					getRandomPosition(m_resources[index].position, (int)index);
-#ifdef TRACK_OTHERS
-					m_resources[index].shieldedBy = -1;
-#endif
-				}
-#ifdef THREADDED
-				m_resourceLock.unlock();
-#endif
-				return m_resources[index].resourceType;
-			}
+	// The current generation number
+	unsigned int generation() const override {
+		return m_generation;
+	}
+
+	// How often the threads have got in each other's way over the resources so far
+	ResourceContention contention() const override {
+		ResourceContention result;
+		result.claims = m_claimCount.load();
+		result.lostClaims = m_lostClaimCount.load();
+		result.movingReads = m_movingReadCount.load();
+		return result;
+	}
+
+	// Returns TRUE if the point is inside a resource, along with the version of the resource for claimResource()
+	bool resourceContains(const size_t index, const FloatPair& position, int indexToIgnore, int mustBelongTo, uint32_t& version) const {
+		if ((int)index == indexToIgnore) return false;
+		// Skip a resource if its shielded by another lifeform
+		if constexpr (Mode::trackOthers) {
+			const int shieldedBy = m_resources[index].shieldedBy;
+			if ((shieldedBy >= 0) && (shieldedBy != mustBelongTo) && (mustBelongTo >= 0)) return false;
 		}
+		FloatPair centre;
+		if (!readResource(index, centre, version)) return false;
 
-#ifdef THREADDED
-		m_resourceLock.unlock();
+		// Calculate the distance away
+		const int64_t distanceX = (int64_t)(position.x - centre.x);
+		const int64_t distanceY = (int64_t)(position.y - centre.y);
+
+		// Use everything squared rather than calling sqrt which isnt the fastest thing in the world
+		return sqrt((double)((distanceX * distanceX) + (distanceY * distanceY))) <= m_resources[index].radius;
+	}
+
+	// Return the index of the resource at a specific coordinate, or -1.  This doesn't change anything.
+	// If version is supplied it receives the version of the resource found, for claimResource()
+	int resourceIndexAtPosition(const FloatPair& position, int indexToIgnore = -1, int mustBelongTo = -1, uint32_t* version = nullptr) const {
+		uint32_t seen;
+#ifdef SPATIAL_GRID
+		// Anything in the grid containing the point is in the cells around it.  Keep the lowest index, the same as checking them all in order
+		int found = -1;
+		uint32_t foundVersion = 0;
+		auto check = [&](const int index) {
+			if ((found >= 0) && (index > found)) return;
+			if (resourceContains(index, position, indexToIgnore, mustBelongTo, seen)) {
+				found = index;
+				foundVersion = seen;
+			}
+		};
+		m_grid.forEachInRing(position.x, position.y, 0, check);
+		m_grid.forEachInRing(position.x, position.y, 1, check);
+		for (const int index : m_largeResources) check(index);
+		if (version && (found >= 0)) *version = foundVersion;
+		return found;
+#else
+		for (size_t index = 0; index < m_resources.size(); index++)
+			if (resourceContains(index, position, indexToIgnore, mustBelongTo, seen)) {
+				if (version) *version = seen;
+				return (int)index;
+			}
+		return -1;
 #endif
-		return ResourceType::rtNone;
 	}
 
-	// Updates position with a random position where there are no resources
-	void getRandomPosition(FloatPair& position, int indexToIgnore = -1) {
+	// Re-spawn a resource that has been consumed.  Only call this when no other thread can be consuming it
+	void respawnResource(const size_t index) {
+		claimResource(index, m_resources[index].version.load());
+	}
+
+	// Return what resource was found at a specific coordinate
+	ResourceType resourceTypeAtPosition(const FloatPair& position, bool consumeResource, int indexToIgnore = -1, int mustBelongTo = -1) {
+		for (;;) {
+			uint32_t version;
+			const int index = resourceIndexAtPosition(position, indexToIgnore, mustBelongTo, &version);
+			if (index < 0) return ResourceType::rtNone;
+
+			const ResourceType type = m_resources[index].resourceType;
+			if ((!consumeResource) || (type == Mode::notConsumable)) return type;
+
+			// If another thread consumed it first then it's moved, so look again
+			if (claimResource(index, version)) return type;
+		}
+	}
+
+	// Updates position with a random position where there are no resources.  With LOCKED_FREE_SPACE only call this
+	// while resources are being consumed if m_freeSpaceLock is held
+	void getRandomPosition(FloatPair& position, RandomStream& random, int indexToIgnore = -1) {
+#ifdef FREE_SPACE_SAMPLER
+		// Only the resources overlapping the spot picked need checking.  If there's no room left it carries on as before
+		uint32_t version;
+		if (m_freeSpace.sample(random, position.x, position.y, [&](const int index) {
+			return resourceContains(index, position, indexToIgnore, -1, version);
+		})) return;
+#endif
+		// Worked out first so it's rounded the same whether or not the size is known when it's compiled
+		const float left = width() * 0.1f, across = width() * 0.8f;
+		const float top = height() * 0.1f, down = height() * 0.8f;
 		do {
-			position.x = (width() * 0.1f) + ((width() * rand() * 0.8f) / RAND_MAX);
-			position.y = (height() * 0.1f) + ((height() * rand() * 0.8f) / RAND_MAX);
+			position.x = left + (across * random.nextFloat());
+			position.y = top + (down * random.nextFloat());
 		} while (resourceTypeAtPosition(position, false, indexToIgnore) != ResourceType::rtNone);
 	}
 	// rtSunlight, rtOil, rtQuickSand
-	// Calculates the distances etc to the nearest of each type of resource
-	void findDirectionToResources(const FloatPair& position, ResourceTarget& targetCell
-#ifdef USE_SOLAR				
-		, ResourceTarget& targetSunlight
-#endif
-#ifdef HAS_QUICKSAND
-		, ResourceTarget& targetQuickSand
-#endif
-#ifdef TRACK_OTHERS
-		, int& resourceIndex
-		, int callerIndex
-#endif
-	) {
-		// Reset 
-#ifdef USE_SOLAR	
+	// Calculates the distances etc to the nearest of each type of resource.  Only the targets the experiment has are updated.
+	// resourceIndex receives the index of the nearest cell, callerIndex is the lifeform asking (MODE4)
+	void findDirectionToResources(const FloatPair& position, ResourceTarget& targetCell, ResourceTarget& targetSunlight, ResourceTarget& targetQuickSand,
+		int& resourceIndex, int callerIndex) {
+		// Reset.  Squared distances are 64 bit as they'd overflow in a big world
 		int nearestSunIndex = -1;
-		int nearestSunValue = 0;
-#endif
-#ifdef HAS_QUICKSAND
+		int64_t nearestSunValue = 0;
+		FloatPair nearestSun;
 		int nearestSandIndex = -1;
-		int nearestSandValue = 0;
-#endif
+		int64_t nearestSandValue = 0;
+		FloatPair nearestSand;
 		int nearestCellIndex = -1;
-		int nearestCellValue = 0;
+		int64_t nearestCellValue = 0;
+		FloatPair nearestCell;
+
+		// Keeps the nearest.  On a tie the lowest index wins, so the order they're checked in doesn't matter
+		auto isNearer = [](const int64_t distance, const int index, const int64_t nearestValue, const int nearestIndex) {
+			return (nearestIndex == -1) || (distance < nearestValue) || ((distance == nearestValue) && (index < nearestIndex));
+		};
+
+		auto consider = [&](const int index) {
+			if constexpr (Mode::trackOthers) {
+				// iF the resource is shielded by another robot, then it's invisible to us
+				const int shieldedBy = m_resources[index].shieldedBy;
+				if ((shieldedBy >= 0) && (shieldedBy != callerIndex)) return;
+			}
+			FloatPair centre;
+			uint32_t version;
+			if (!readResource(index, centre, version)) return;
 
-		// Iterate
-		for (size_t index = 0; index < m_resources.size(); index++) {
-#ifdef TRACK_OTHERS
-			// iF the resource is shielded by another robot, then it's invisible to us
-			if ((m_resources[index].shieldedBy >= 0) && (m_resources[index].shieldedBy != callerIndex)) continue;
-#endif
 			// Calculate the distance away
-			int distanceX = (int)abs(position.x - (int)m_resources[index].position.x);
-			int distanceY = (int)abs(position.y - (int)m_resources[index].position.y);
+			int64_t distanceX = (int64_t)std::abs(position.x - (int)centre.x);
+			int64_t distanceY = (int64_t)std::abs(position.y - (int)centre.y);
 			if (distanceX > halfWidth()) distanceX = width() - distanceX;
 			if (distanceY > halfHeight()) distanceY = height() - distanceY;
 
-			int distance = ((distanceX * distanceX) + (distanceY * distanceY)) - m_resources[index].radiusSquared;
+			int64_t distance = ((distanceX * distanceX) + (distanceY * distanceY)) - m_resources[index].radiusSquared;
 			if (distance < 0) distance = 0;
 
 			// Check the resource type and keep the nearest
 			switch (m_resources[index].resourceType) {
-#ifdef USE_SOLAR	
 			case ResourceType::rtSunlight:
-				if ((distance < nearestSunValue) || (nearestSunIndex == -1)) {
-					nearestSunIndex = (int)index;
-					nearestSunValue = distance;
+				if constexpr (Mode::useSolar) {
+					if (isNearer(distance, index, nearestSunValue, nearestSunIndex)) {
+						nearestSunIndex = index;
+						nearestSunValue = distance;
+						nearestSun = centre;
+					}
 				}
 				break;
-#endif
 			case ResourceType::rtCell:
-				if ((distance < nearestCellValue) || (nearestCellIndex == -1)) {
-					nearestCellIndex = (int)index;
+				if (isNearer(distance, index, nearestCellValue, nearestCellIndex)) {
+					nearestCellIndex = index;
 					nearestCellValue = distance;
+					nearestCell = centre;
 				}
 				break;
 
-#ifdef HAS_QUICKSAND
 			case ResourceType::rtQuickSand:
-				if ((distance < nearestSandValue) || (nearestSandIndex == -1)) {
-					nearestSandIndex = (int)index;
-					nearestSandValue = distance;
+				if constexpr (Mode::hasQuickSand) {
+					if (isNearer(distance, index, nearestSandValue, nearestSandIndex)) {
+						nearestSandIndex = index;
+						nearestSandValue = distance;
+						nearestSand = centre;
+					}
 				}
 				break;
+
+			default:
+				break;
+			}
+		};
+
+#ifdef SPATIAL_GRID
+		// Returns TRUE if nothing in the grid could beat the nearest of each type found so far
+		auto isFinished = [&](const int64_t nearestPossible) {
+			bool finished = (m_gridTypeCount[(int)ResourceType::rtCell] == 0) || ((nearestCellIndex >= 0) && (nearestCellValue < nearestPossible));
+			if constexpr (Mode::useSolar)
+				finished &= (m_gridTypeCount[(int)ResourceType::rtSunlight] == 0) || ((nearestSunIndex >= 0) && (nearestSunValue < nearestPossible));
+			if constexpr (Mode::hasQuickSand)
+				finished &= (m_gridTypeCount[(int)ResourceType::rtQuickSand] == 0) || ((nearestSandIndex >= 0) && (nearestSandValue < nearestPossible));
+			return finished;
+		};
+
+		for (const int index : m_largeResources) consider(index);
+
+		// Work outwards ring by ring.  Everything in ring n is at least (n-1) cells away, less a couple of pixels for the rounding above
+		const float cellSize = m_grid.cellWidth() < m_grid.cellHeight() ? m_grid.cellWidth() : m_grid.cellHeight();
+		for (int ring = 0; ring < m_grid.numRings(); ring++) {
+			const int64_t reach = (int64_t)((ring - 1) * cellSize) - 2;
+			if ((reach > 0) && (isFinished((reach * reach) - ((int64_t)m_gridRadius * m_gridRadius)))) break;
+			m_grid.forEachInRing(position.x, position.y, ring, consider);
+		}
+#else
+#ifdef NEAREST_RESOURCE_CACHE
+		// Nothing needs checking if the lifeform can't have moved far enough for the nearest to change
+		const uint64_t respawns = m_respawns.count();
+		int cachedIndex[NUM_RESOURCE_TYPES];
+		FloatPair cachedCentre[NUM_RESOURCE_TYPES];
+		if (readNearestCache(callerIndex, position, cachedIndex, cachedCentre)) {
+			if constexpr (Mode::useSolar) {
+				nearestSunIndex = cachedIndex[(int)ResourceType::rtSunlight];
+				nearestSun = cachedCentre[(int)ResourceType::rtSunlight];
+			}
+			if constexpr (Mode::hasQuickSand) {
+				nearestSandIndex = cachedIndex[(int)ResourceType::rtQuickSand];
+				nearestSand = cachedCentre[(int)ResourceType::rtQuickSand];
+			}
+			nearestCellIndex = cachedIndex[(int)ResourceType::rtCell];
+			nearestCell = cachedCentre[(int)ResourceType::rtCell];
+		}
+		else
 #endif
+		{
+#ifdef SIMD_RESOURCE_SCAN
+			if (m_scanResources) {
+				// Check them all at once.  This finds exactly what consider() would have
+				int32_t nearestIndex[NUM_RESOURCE_TYPES], nearestDistance[NUM_RESOURCE_TYPES], secondDistance[NUM_RESOURCE_TYPES];
+				m_resourceTable.nearest(position.x, position.y, width(), height(), NUM_RESOURCE_TYPES, nearestIndex, nearestDistance, secondDistance);
+				if constexpr (Mode::useSolar) {
+					nearestSunIndex = nearestIndex[(int)ResourceType::rtSunlight];
+					if (nearestSunIndex >= 0) nearestSun = m_resources[nearestSunIndex].position;
+				}
+				if constexpr (Mode::hasQuickSand) {
+					nearestSandIndex = nearestIndex[(int)ResourceType::rtQuickSand];
+					if (nearestSandIndex >= 0) nearestSand = m_resources[nearestSandIndex].position;
+				}
+				nearestCellIndex = nearestIndex[(int)ResourceType::rtCell];
+				if (nearestCellIndex >= 0) nearestCell = m_resources[nearestCellIndex].position;
+#ifdef NEAREST_RESOURCE_CACHE
+				fillNearestCache(callerIndex, position, respawns, nearestIndex, secondDistance);
+#endif
+			}
+			else
+#endif
+			{
+				// Iterate
+				for (size_t index = 0; index < m_resources.size(); index++) consider((int)index);
 			}
 		}
+#endif
 
-#ifdef USE_SOLAR	
-		// Calculate the target and direction for the items
-		targetSunlight.available = nearestSunIndex >= 0;
-		if (targetSunlight.available) {
-			targetSunlight.target = m_resources[nearestSunIndex].position;
-			calculateBrainDestination(position, targetSunlight);
+		if constexpr (Mode::useSolar) {
+			// Calculate the target and direction for the items
+			targetSunlight.available = nearestSunIndex >= 0;
+			if (targetSunlight.available) {
+				targetSunlight.target = nearestSun;
+				calculateBrainDestination(position, targetSunlight);
+			}
 		}
-#endif
 
-#ifdef TRACK_OTHERS
-		resourceIndex = nearestCellIndex;
+#ifndef DETERMINISTIC_STEPPING
+		// Everyone else can see the new target straight away
+		if constexpr (Mode::trackOthers) {
+			if (nearestCellIndex != resourceIndex) retarget(resourceIndex, nearestCellIndex);
+		}
 #endif
+		resourceIndex = nearestCellIndex;
 		targetCell.available = nearestCellIndex >= 0;
 		if (targetCell.available) {
-			targetCell.target = m_resources[nearestCellIndex].position;
+			targetCell.target = nearestCell;
 			calculateBrainDestination(position, targetCell);
 		}
 
-#ifdef HAS_QUICKSAND
-		targetQuickSand.available = nearestSandIndex >= 0;
-		if (targetQuickSand.available) {
-			targetQuickSand.target = m_resources[nearestSandIndex].position;
-			calculateBrainDestination(position, targetQuickSand);
+		if constexpr (Mode::hasQuickSand) {
+			targetQuickSand.available = nearestSandIndex >= 0;
+			if (targetQuickSand.available) {
+				targetQuickSand.target = nearestSand;
+				calculateBrainDestination(position, targetQuickSand);
+			}
 		}
-#endif
 	}
 
 	// Wraps the coordinates so if they go off one edge of the simulation they appear on the other side
@@ -599,16 +1373,24 @@ public:
 	}
 
 	// Draw the lifeforms.  It iterates resources and calls the callback
-	void drawLifeforms(std::function<void(const LifeformData& lifeform)> onDraw) {
-		for (const LifeformData& r : m_lifeForms) onDraw(r);
+	void drawLifeforms(std::function<void(const LifeformData<Mode>& lifeform)> onDraw) {
+		for (const LifeformData<Mode>& r : m_lifeForms) onDraw(r);
 	}
 
 	// Snapshot to disk
-	bool saveSnapshot(const std::wstring& filename, unsigned int generation, const GenStatistics& lastGeneration) {
-		std::fstream file = std::fstream(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);		
+	bool saveSnapshot(const std::wstring& filename, unsigned int generation, const GenStatistics& lastGeneration) override {
+		std::fstream file = openSnapshot(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);		
 		if (!file.is_open()) return false;
 
-		// Save generation number
+		// Save the shape of the brains, then the generation number
+		const std::vector<size_t> layers = brainLayers();
+		const uint32_t numLayers = (uint32_t)layers.size();
+		if (!file.write((const char*)&m_snapshotTag, sizeof(m_snapshotTag))) return false;
+		if (!file.write((const char*)&numLayers, sizeof(numLayers))) return false;
+		for (const size_t layer : layers) {
+			const uint32_t size = (uint32_t)layer;
+			if (!file.write((const char*)&size, sizeof(size))) return false;
+		}
 		if (!file.write((const char*)&generation, sizeof(generation))) return false;
 		if (!file.write((const char*)&lastGeneration, sizeof(lastGeneration))) return false;
 		unsigned int total = 0;
@@ -616,7 +1398,7 @@ public:
 
 		// Weights
 		std::vector<float> weights;
-		for (LifeformData& data : m_lifeForms) {
+		for (LifeformData<Mode>& data : m_lifeForms) {
 			data.brain->getWeights(weights);
 			if (total == 0) total = (unsigned int)weights.size();
 		}
@@ -631,26 +1413,49 @@ public:
 	}
 
 	// Load from disk
-	bool loadSnapshot(const std::wstring& filename, unsigned int& generationLoaded, GenStatistics& lastGeneration) {
-		std::fstream file = std::fstream(filename, std::ofstream::in | std::ofstream::binary);
+	bool loadSnapshot(const std::wstring& filename, unsigned int& generationLoaded, GenStatistics& lastGeneration) override {
+		if (m_lifeForms.empty()) return false;		// No brains to load it into
+		std::fstream file = openSnapshot(filename, std::ofstream::in | std::ofstream::binary);
 		if (!file.is_open()) return false;
 
-		// Load generation number
-		if (!file.read((char*)&generationLoaded, sizeof(generationLoaded))) return false;
+		// The brains are a different shape in each experiment, and have changed over time (MODE4 went from 7 inputs to 9), so
+		// make sure it's one of ours.  An older snapshot without the shape only loads if it has the right number of weights,
+		// none of the old shapes had the same number as a different current one
+		uint32_t tag = 0;
+		if (!file.read((char*)&tag, sizeof(tag))) return false;
+		if (tag == m_snapshotTag) {
+			const std::vector<size_t> layers = brainLayers();
+			uint32_t numLayers = 0;
+			if ((!file.read((char*)&numLayers, sizeof(numLayers))) || (numLayers != layers.size())) return false;
+			for (const size_t layer : layers) {
+				uint32_t size = 0;
+				if ((!file.read((char*)&size, sizeof(size))) || (size != layer)) return false;
+			}
+			if (!file.read((char*)&generationLoaded, sizeof(generationLoaded))) return false;
+		}
+		else generationLoaded = tag;
+
+		// Load the last generation's statistics
 		if (!file.read((char*)&lastGeneration, sizeof(lastGeneration))) return false;
 		unsigned int total = 0;
 
 		if (!file.read((char*)&total, sizeof(total))) return false;
 
 		std::vector<float> weights;
-		weights.resize(total * POPULATION_SIZE);
+		m_lifeForms[0].brain->getWeights(weights);
+		if (total != weights.size()) return false;
+		weights.resize(total * m_lifeForms.size());
 		if (!file.read((char*)weights.data(), sizeof(float) * weights.size())) return false;
 
 		// Load
-		for (LifeformData& data : m_lifeForms) {
-			weights.erase(weights.begin(), weights.begin() + data.brain->setWeights(weights));
+		m_generation = generationLoaded;
+		size_t position = 0;
+		for (LifeformData<Mode>& data : m_lifeForms) {
+			position += data.brain->setWeights(ConstGenomeView(weights.data() + position, weights.size() - position));
 			data.lifeForm->resetAge();
 		}
+		resetActiveLifeForms();
+		if constexpr (Mode::trackOthers) resetTargets();
 
 		file.close();
 		return true;
@@ -0,0 +1,127 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <vector>
+
+// Uniform grid over a world that wraps at the edges.  Each item (a resource index) lives in the cell containing its centre.
+// Cells are visited in rings around a point, ring 0 is the cell the point is in, ring 1 the 8 around it and so on.
+// Every cell is visited exactly once across all of the rings, taking the shortest way round the world to it.
+// The items in a cell are a linked list through the items themselves, so moving one never allocates memory
+class SpatialGrid {
+private:
+	int m_columns, m_rows;
+	float m_cellWidth, m_cellHeight;
+	std::vector<int> m_cells;					// First item in each cell, or -1
+	std::vector<int> m_itemCell;				// Which cell each item is in, or -1
+	std::vector<int> m_next, m_previous;		// The other items in the same cell, or -1
+
+	// Add an item to the front of a cell's list
+	void link(const int item, const int cell) {
+		m_itemCell[item] = cell;
+		m_previous[item] = -1;
+		m_next[item] = m_cells[cell];
+		if (m_next[item] >= 0) m_previous[m_next[item]] = item;
+		m_cells[cell] = item;
+	}
+
+	// Take an item out of its cell's list
+	void unlink(const int item) {
+		if (m_previous[item] >= 0) m_next[m_previous[item]] = m_next[item];
+		else m_cells[m_itemCell[item]] = m_next[item];
+		if (m_next[item] >= 0) m_previous[m_next[item]] = m_previous[item];
+	}
+
+	// Cell index containing a point, wrapping if its off the edge
+	int cellAt(const float x, const float y) const {
+		int column = (int)(x / m_cellWidth) % m_columns;
+		int row = (int)(y / m_cellHeight) % m_rows;
+		if (column < 0) column += m_columns;
+		if (row < 0) row += m_rows;
+		return (row * m_columns) + column;
+	}
+
+	// Call onItem for everything in the cell offset (dx, dy) from (column, row)
+	template<typename F>
+	void visitCell(const int column, const int row, const int dx, const int dy, F& onItem) const {
+		const int x = (column + dx + m_columns) % m_columns;
+		const int y = (row + dy + m_rows) % m_rows;
+		for (int item = m_cells[(y * m_columns) + x]; item >= 0; item = m_next[item]) onItem(item);
+	}
+
+public:
+	// cellSize is the smallest a cell can be.  The cells are widened so a whole number of them fit across the world, which is
+	// why anything with a radius up to cellSize less a pixel or two is always within the cells next to its own.  Only a world
+	// narrower than cellSize gets a smaller cell, as it's then one cell across
+	SpatialGrid(const int width, const int height, const int cellSize) {
+		m_columns = width / cellSize;
+		m_rows = height / cellSize;
+		if (m_columns < 1) m_columns = 1;
+		if (m_rows < 1) m_rows = 1;
+		m_cellWidth = (float)width / (float)m_columns;
+		m_cellHeight = (float)height / (float)m_rows;
+		m_cells.resize((size_t)m_columns * (size_t)m_rows, -1);
+	}
+
+	// Size of a cell
+	float cellWidth() const { return m_cellWidth; };
+	float cellHeight() const { return m_cellHeight; };
+
+	// Number of rings needed to cover the whole world
+	int numRings() const {
+		return (m_columns > m_rows ? m_columns : m_rows) / 2 + 1;
+	}
+
+	// Add an item at a position
+	void insert(const int item, const float x, const float y) {
+		if (item >= (int)m_itemCell.size()) {
+			m_itemCell.resize(item + 1, -1);
+			m_next.resize(item + 1, -1);
+			m_previous.resize(item + 1, -1);
+		}
+		link(item, cellAt(x, y));
+	}
+
+	// Update the cell an item is in after it has moved
+	void move(const int item, const float x, const float y) {
+		const int cell = cellAt(x, y);
+		const int oldCell = m_itemCell[item];
+		if (cell == oldCell) return;
+
+		unlink(item);
+		link(item, cell);
+	}
+
+	// Call onItem(item) for every item in ring 'ring' around the point
+	template<typename F>
+	void forEachInRing(const float x, const float y, const int ring, F onItem) const {
+		const int cell = cellAt(x, y);
+		const int column = cell % m_columns;
+		const int row = cell / m_columns;
+
+		// The offsets that reach each column/row once going the shortest way round
+		const int lowX = -((m_columns - 1) / 2), highX = m_columns / 2;
+		const int lowY = -((m_rows - 1) / 2), highY = m_rows / 2;
+		const int firstX = -ring < lowX ? lowX : -ring, lastX = ring > highX ? highX : ring;
+		const int firstY = -ring < lowY ? lowY : -ring, lastY = ring > highY ? highY : ring;
+
+		for (int dy = firstY; dy <= lastY; dy++) {
+			if ((dy == -ring) || (dy == ring)) {
+				// Top and bottom edges of the ring
+				for (int dx = firstX; dx <= lastX; dx++) visitCell(column, row, dx, dy, onItem);
+			}
+			else {
+				// Just the left and right sides
+				if (-ring >= lowX) visitCell(column, row, -ring, dy, onItem);
+				if ((ring <= highX) && (ring != 0)) visitCell(column, row, ring, dy, onItem);
+			}
+		}
+	}
+};
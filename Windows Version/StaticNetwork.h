@@ -0,0 +1,141 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <stdlib.h>
+#include "Activation.h"
+#include "Random.h"
+
+// A neural network whose topology is fixed at compile time, eg. StaticNetwork<5, 14, 12, 2>
+// All of the sizes are constants so the loops can be fully unrolled and vectorised by the compiler.
+// The weights are stored in exactly the same order as NeuralNetwork, so the genomes (and snapshots) are interchangeable
+template<size_t... LayerSizes>
+class StaticNetwork {
+public:
+	static_assert(sizeof...(LayerSizes) >= 2, "A network needs at least an input and an output layer");
+
+	// Number of layers, including the input layer
+	static constexpr size_t numLayers() {
+		return sizeof...(LayerSizes);
+	}
+
+	// Number of neurons in a layer
+	static constexpr size_t layerSize(const size_t layer) {
+		constexpr size_t sizes[] = { LayerSizes... };
+		return sizes[layer];
+	}
+
+	// Number of weights in all the layers before this one.  Each neuron has an output weight followed by one per input
+	static constexpr size_t weightsBefore(const size_t layer) {
+		return layer < 2 ? 0 : weightsBefore(layer - 1) + (layerSize(layer - 1) * (layerSize(layer - 2) + 1));
+	}
+
+	// Number of neuron values in all the layers before this one
+	static constexpr size_t valuesBefore(const size_t layer) {
+		return layer < 1 ? 0 : valuesBefore(layer - 1) + layerSize(layer - 1);
+	}
+
+	// Total size of the genome
+	static constexpr size_t numWeights() {
+		return weightsBefore(numLayers());
+	}
+
+	// Total number of neuron values
+	static constexpr size_t numValues() {
+		return valuesBefore(numLayers());
+	}
+
+	// The layer sizes in the form NeuralNetwork takes them
+	static std::vector<size_t> layers() {
+		return { LayerSizes... };
+	}
+
+private:
+	std::array<float, numWeights()> m_weights;
+	std::array<float, numValues()> m_values;
+	ActivationFunction m_activation;
+
+	// Calculate the output of layer 'Layer' and then all of the ones after it
+	template<size_t Layer>
+	void updateFrom(std::integral_constant<size_t, Layer>) {
+		constexpr size_t inputs = layerSize(Layer - 1);
+		constexpr size_t outputs = layerSize(Layer);
+		constexpr size_t stride = inputs + 1;
+		const float* row = m_weights.data() + weightsBefore(Layer);
+		const float* in = m_values.data() + valuesBefore(Layer - 1);
+		float* out = m_values.data() + valuesBefore(Layer);
+
+		for (size_t neuron = 0; neuron < outputs; neuron++) {
+			// row[0] is the output weight, the input weights follow it
+			float total = 0;
+			for (size_t input = 0; input < inputs; input++)
+				total += row[(neuron * stride) + input + 1] * in[input];
+			out[neuron] = total;
+		}
+		Activation::apply(m_activation, out, outputs);
+
+		updateFrom(std::integral_constant<size_t, Layer + 1>());
+	}
+
+	// Finished
+	void updateFrom(std::integral_constant<size_t, numLayers()>) {}
+
+public:
+	//  Rather than mess around, disable the copy methods
+	StaticNetwork(const StaticNetwork&) = delete;
+	StaticNetwork& operator=(StaticNetwork&) = delete;
+
+	// Create a network.  Same defaults as NeuralNetwork, all weights start at 1
+	StaticNetwork(const ActivationFunction activation = ActivationFunction::afSigmoid) : m_activation(activation) {
+		m_weights.fill(1.0f);
+		m_values.fill(0.0f);
+	}
+
+	// Change the activation function used by the neurons
+	void setActivation(const ActivationFunction activation) {
+		m_activation = activation;
+	}
+
+	// Randomize all the weighting in the layer
+	void randomize(RandomStream& random) {
+		for (float& weight : m_weights)
+			weight = random.nextFloat();
+	}
+
+	// Set an inputs value
+	void setInput(size_t inputNumber, const float value) {
+		m_values[inputNumber] = value;
+	}
+
+	// Get all weights that make up this network
+	void getWeights(std::vector<float>& weights) const {
+		weights.insert(weights.end(), m_weights.begin(), m_weights.end());
+	}
+
+	// Set all weights that make up this network.  Returns the weights used
+	size_t setWeights(const std::vector<float>& weights) {
+		std::copy(weights.begin(), weights.begin() + numWeights(), m_weights.begin());
+		return numWeights();
+	}
+
+	// Get the output from a specific neuron
+	float value(size_t outputNeuron) const {
+		return m_values[valuesBefore(numLayers() - 1) + outputNeuron];
+	}
+
+	// Calculates the latest output from the network
+	void update() {
+		updateFrom(std::integral_constant<size_t, 1>());
+	}
+};
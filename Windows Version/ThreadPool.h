@@ -0,0 +1,189 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// How many times a worker checks for new work before going to sleep
+#define THREADPOOL_SPIN_COUNT		2000
+
+// Portable pool of worker threads.
+// parallelFor() splits a range into chunks and deals them out evenly between the workers. A worker that runs out of
+// chunks steals them from the end of another worker's share. The thread calling parallelFor() works as worker 0, and
+// the call returns once every chunk is done, so each call acts as a barrier between steps
+class ThreadPool {
+public:
+	// Called with a range [first, last) to process and the number of the worker running it
+	typedef std::function<void(size_t first, size_t last, size_t worker)> RangeFunction;
+
+private:
+	// A worker's share of the chunks, packed as (first << 32) | end so it can be updated in one go.
+	// The owner takes chunks from the front, thieves take them from the back
+	struct alignas(64) WorkQueue {
+		std::atomic<uint64_t> chunks;
+	};
+
+	std::vector<std::thread> m_threads;
+	std::unique_ptr<WorkQueue[]> m_queues;
+	size_t m_numWorkers;
+
+	// The job currently running
+	const RangeFunction* m_job = nullptr;
+	size_t m_jobSize = 0;
+	size_t m_chunkSize = 1;
+
+	// Synchronisation.  m_jobNumber changing tells the workers there's a new job, m_remaining counts workers still busy
+	std::atomic<uint64_t> m_jobNumber;
+	std::atomic<size_t> m_remaining;
+	std::atomic<size_t> m_sleeping;
+	std::atomic<bool> m_terminate;
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+
+	// Take the next chunk from the front of a worker's own queue
+	bool takeChunk(WorkQueue& queue, size_t& chunk) {
+		uint64_t current = queue.chunks.load(std::memory_order_acquire);
+		for (;;) {
+			const uint64_t first = current >> 32, end = current & 0xFFFFFFFF;
+			if (first >= end) return false;
+			if (queue.chunks.compare_exchange_weak(current, ((first + 1) << 32) | end, std::memory_order_acq_rel)) {
+				chunk = (size_t)first;
+				return true;
+			}
+		}
+	}
+
+	// Steal a chunk from the back of someone else's queue
+	bool stealChunk(WorkQueue& queue, size_t& chunk) {
+		uint64_t current = queue.chunks.load(std::memory_order_acquire);
+		for (;;) {
+			const uint64_t first = current >> 32, end = current & 0xFFFFFFFF;
+			if (first >= end) return false;
+			if (queue.chunks.compare_exchange_weak(current, (first << 32) | (end - 1), std::memory_order_acq_rel)) {
+				chunk = (size_t)(end - 1);
+				return true;
+			}
+		}
+	}
+
+	// Run chunks until there are none left anywhere
+	void runChunks(const size_t worker) {
+		size_t chunk;
+		for (;;) {
+			bool found = takeChunk(m_queues[worker], chunk);
+			for (size_t other = 1; (!found) && (other < m_numWorkers); other++)
+				found = stealChunk(m_queues[(worker + other) % m_numWorkers], chunk);
+			if (!found) return;
+
+			const size_t first = chunk * m_chunkSize;
+			const size_t last = (first + m_chunkSize < m_jobSize) ? first + m_chunkSize : m_jobSize;
+			(*m_job)(first, last, worker);
+		}
+	}
+
+	// Main loop for each of the threads
+	void workerThread(const size_t worker) {
+		uint64_t lastJob = 0;
+		for (;;) {
+			// Wait for the next job, spinning for a short while before sleeping
+			for (size_t spin = 0; m_jobNumber.load(std::memory_order_acquire) == lastJob; spin++) {
+				if (m_terminate.load()) return;
+				if (spin < THREADPOOL_SPIN_COUNT) {
+					std::this_thread::yield();
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_sleeping++;
+				m_wake.wait(lock, [this, lastJob]() { return (m_jobNumber.load() != lastJob) || m_terminate.load(); });
+				m_sleeping--;
+			}
+			if (m_terminate.load()) return;
+			lastJob = m_jobNumber.load(std::memory_order_acquire);
+
+			runChunks(worker);
+			m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+		}
+	}
+
+public:
+	// Rather than mess around, disable the copy methods
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&) = delete;
+
+	// Create the pool.  numWorkers includes the calling thread, 0 means one per CPU core
+	ThreadPool(size_t numWorkers = 0) : m_jobNumber(0), m_remaining(0), m_sleeping(0), m_terminate(false) {
+		if (numWorkers < 1) numWorkers = std::thread::hardware_concurrency();
+		if (numWorkers < 1) numWorkers = 1;
+		m_numWorkers = numWorkers;
+		m_queues.reset(new WorkQueue[m_numWorkers]);
+		for (size_t worker = 0; worker < m_numWorkers; worker++) m_queues[worker].chunks = 0;
+
+		for (size_t worker = 1; worker < m_numWorkers; worker++)
+			m_threads.push_back(std::thread([this, worker]() { workerThread(worker); }));
+	}
+
+	// Stop all of the threads
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_terminate = true;
+		}
+		m_wake.notify_all();
+		for (std::thread& thread : m_threads)
+			if (thread.joinable()) thread.join();
+	}
+
+	// Number of workers, including the calling thread
+	size_t numWorkers() const {
+		return m_numWorkers;
+	}
+
+	// Run job over [0, count) in chunks of chunkSize, returning once it's all done.  Only call this from one thread at a time
+	void parallelFor(const size_t count, const size_t chunkSize, const RangeFunction& job) {
+		if (count < 1) return;
+		m_job = &job;
+		m_jobSize = count;
+		m_chunkSize = chunkSize < 1 ? 1 : chunkSize;
+
+		// Not worth waking anyone up for a single chunk
+		if (count <= m_chunkSize) {
+			job(0, count, 0);
+			return;
+		}
+
+		// Deal the chunks out evenly
+		const size_t numChunks = (count + m_chunkSize - 1) / m_chunkSize;
+		for (size_t worker = 0; worker < m_numWorkers; worker++) {
+			const uint64_t first = (numChunks * worker) / m_numWorkers;
+			const uint64_t end = (numChunks * (worker + 1)) / m_numWorkers;
+			m_queues[worker].chunks.store((first << 32) | end, std::memory_order_relaxed);
+		}
+
+		// Start the workers.  Only bother with the lock if one of them has gone to sleep
+		m_remaining.store(m_numWorkers - 1, std::memory_order_relaxed);
+		m_jobNumber.fetch_add(1);
+		if (m_sleeping.load() > 0) {
+			{ std::lock_guard<std::mutex> lock(m_lock); }
+			m_wake.notify_all();
+		}
+
+		// Do our share, then wait for everyone else
+		runChunks(0);
+		while (m_remaining.load(std::memory_order_acquire) > 0)
+			std::this_thread::yield();
+	}
+};
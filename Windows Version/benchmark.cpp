@@ -0,0 +1,980 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+// Measures how fast the parts of the simulation are, and checks the fast versions still give the right answers.
+// Each suite is one measurement, run with 'ga1benchmark <suite>'.  By default it runs 'scaling', which steps the population
+// up from 30 to 100,000 lifeforms, with the world and the number of batteries growing with it so there's the same room and
+// food for each of them as in the normal world.  For each size it reports the memory used per lifeform and how many steps
+// a second it manages.  Build with SPATIAL_GRID defined for the big sizes, without it every lifeform checks every battery each step.
+// A suite that finds something wrong makes the program return 1, so CTest runs the checks with small sizes
+
+#include "Simulation.h"
+#include "StaticNetwork.h"
+#include "ResourceTable.h"
+#include "SpatialGrid.h"
+#include "FreeSpace.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+// Every allocation goes through here so the memory a simulation uses, and how often it allocates, can be counted.
+// Each block has its size in front of it
+static std::atomic<size_t> g_bytesAllocated(0);
+static std::atomic<size_t> g_allocations(0);
+
+#define ALLOCATION_HEADER		16		// Keeps the block aligned the same as malloc's
+
+void* operator new(size_t size) {
+	char* block = (char*)malloc(size + ALLOCATION_HEADER);
+	if (!block) throw std::bad_alloc();
+	*(size_t*)block = size;
+	g_bytesAllocated += size;
+	g_allocations++;
+	return block + ALLOCATION_HEADER;
+}
+
+void operator delete(void* pointer) noexcept {
+	if (!pointer) return;
+	char* block = (char*)pointer - ALLOCATION_HEADER;
+	g_bytesAllocated -= *(size_t*)block;
+	free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+// Over-aligned types (alignas more than 16) come through here.  The block is moved up to the alignment, and the start of
+// what malloc returned is kept in front of the size
+void* operator new(size_t size, std::align_val_t alignment) {
+	const size_t align = std::max((size_t)alignment, (size_t)ALLOCATION_HEADER);
+	char* block = (char*)malloc(size + align + ALLOCATION_HEADER);
+	if (!block) throw std::bad_alloc();
+	char* data = (char*)(((uintptr_t)block + ALLOCATION_HEADER + align - 1) & ~(uintptr_t)(align - 1));
+	((size_t*)data)[-1] = size;
+	((char**)data)[-2] = block;
+	g_bytesAllocated += size;
+	g_allocations++;
+	return data;
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	if (!pointer) return;
+	g_bytesAllocated -= ((size_t*)pointer)[-1];
+	free(((char**)pointer)[-2]);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept { operator delete(pointer, alignment); }
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept { operator delete(pointer, alignment); }
+void operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept { operator delete(pointer, alignment); }
+
+// Populations to try
+static const int g_populationSizes[] = { 30, 100, 300, 1000, 3000, 10000, 30000, 100000 };
+
+// Batteries in each experiment's normal world
+static int defaultCells(const int mode) {
+	switch (mode) {
+		case MODE1: return ExperimentMode<MODE1>::numCells;
+		case MODE2: return ExperimentMode<MODE2>::numCells;
+		case MODE3: return ExperimentMode<MODE3>::numCells;
+		case MODE4: return ExperimentMode<MODE4>::numCells;
+		default: return 0;
+	}
+}
+
+// Settings shared by the suites
+struct BenchmarkOptions {
+	int mode = EXPERIMENT_MODE;
+	int numSteps = 100;
+	int maxPopulation = 0;			// Largest population to try, 0 for the suite's own limit
+	uint64_t seed = 1;
+};
+
+// The brain each experiment uses
+static std::vector<size_t> networkLayers(const int mode) {
+	switch (mode) {
+		case MODE1: return ExperimentMode<MODE1>::networkLayers();
+		case MODE2: return ExperimentMode<MODE2>::networkLayers();
+		case MODE3: return ExperimentMode<MODE3>::networkLayers();
+		case MODE4: return ExperimentMode<MODE4>::networkLayers();
+		default: return {};
+	}
+}
+
+// The brain each experiment's lifeforms actually have, which can be bigger with LARGER_BRAIN
+static std::vector<size_t> brainLayers(const int mode) {
+	switch (mode) {
+		case MODE1: return Simulation<ExperimentMode<MODE1>>::brainLayers();
+		case MODE2: return Simulation<ExperimentMode<MODE2>>::brainLayers();
+		case MODE3: return Simulation<ExperimentMode<MODE3>>::brainLayers();
+		case MODE4: return Simulation<ExperimentMode<MODE4>>::brainLayers();
+		default: return {};
+	}
+}
+
+// Runs work() over and over for about a fifth of a second and returns how many times a second it managed
+template<typename Work>
+static double timesPerSecond(Work work) {
+	const std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+	size_t runs = 0;
+	double seconds = 0;
+	while (seconds < 0.2) {
+		work();
+		runs++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+	return runs / seconds;
+}
+
+// A world with the same space and number of batteries per lifeform as the normal world
+static WorldSettings scaledWorld(const int mode, const int populationSize) {
+	const double scale = sqrt((double)populationSize / POPULATION_SIZE);
+	WorldSettings world;
+	world.populationSize = populationSize;
+	if (scale > 1.0) {
+		world.width = (int)(SIMULATION_WIDTH * scale);
+		world.height = (int)(SIMULATION_HEIGHT * scale);
+		world.numCells = (int)(((int64_t)defaultCells(mode) * populationSize) / POPULATION_SIZE);
+	}
+	else world.numCells = defaultCells(mode);
+	return world;
+}
+
+// Memory and steps per second from 30 to 100,000 lifeforms
+static bool runScaling(const BenchmarkOptions& options) {
+	printf("Mode %i, %i steps at each size", options.mode, options.numSteps);
+#ifdef THREADDED
+	printf(", threaded");
+#endif
+#ifdef SPATIAL_GRID
+	printf(", spatial grid");
+#endif
+#ifdef SIMD_RESOURCE_SCAN
+	printf(", SIMD resource scan");
+#endif
+#ifdef NEAREST_RESOURCE_CACHE
+	printf(", nearest resource cache");
+#endif
+	printf("\n\n");
+	printf(" Lifeforms        World  Batteries   Memory  Per lifeform  Setup (s)   Steps/s  Lifeform steps/s\n");
+
+	for (const int populationSize : g_populationSizes) {
+		if (populationSize > (options.maxPopulation ? options.maxPopulation : 100000)) break;
+
+		const WorldSettings world = scaledWorld(options.mode, populationSize);
+		const size_t bytesBefore = g_bytesAllocated;
+		std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+		Experiment* simulation = createExperiment(options.mode, options.seed, world);
+		const double setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		const double megabytes = (double)(g_bytesAllocated - bytesBefore) / (1024.0 * 1024.0);
+
+		// Nothing runs out of battery in the first INITIAL_STEPS, so every step has the whole population in it
+		int stepsRun = 0;
+		startTime = std::chrono::steady_clock::now();
+		while ((stepsRun < options.numSteps) && (simulation->step())) stepsRun++;
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		delete simulation;
+
+		const double stepsPerSecond = seconds > 0 ? stepsRun / seconds : 0;
+		char worldSize[32];
+		snprintf(worldSize, sizeof(worldSize), "%ix%i", world.width, world.height);
+		printf("%10i  %11s  %9i  %6.1fMB  %9.0f B  %9.2f  %8.1f  %16.0f\n", populationSize, worldSize, world.numCells,
+			megabytes, (megabytes * 1024.0 * 1024.0) / populationSize, setupSeconds, stepsPerSecond, stepsPerSecond * populationSize);
+		fflush(stdout);
+	}
+	return true;
+}
+
+static const char* simdLevelName(const SimdLevel level) {
+	switch (level) {
+		case SimdLevel::slAVX512: return "AVX-512";
+		case SimdLevel::slAVX2: return "AVX2";
+		default: return "scalar";
+	}
+}
+
+// Checks the AVX2 and AVX-512 kernels against the scalar ones and times each of them.  The brains of all four experiments
+// are given random weights (-1 to 1) and inputs, and every neuron has to be within SIMD_SIGMOID_TOLERANCE of the scalar
+// answer, whether the brain is updated on its own or in a batch.  sinCos() has to be within SIMD_SINCOS_TOLERANCE of double precision
+static bool runKernels(const BenchmarkOptions& options) {
+	const SimdLevel best = SimdKernels::detect();
+	const SimdLevel levels[] = { SimdLevel::slScalar, SimdLevel::slAVX2, SimdLevel::slAVX512 };
+	const size_t numInputSets = 256;
+	const size_t batchSize = 1000;
+	bool passed = true;
+
+	printf("Best instruction set on this CPU: %s\n\n", simdLevelName(best));
+
+	// One brain per experiment plus a batch the shape of the MODE1 brain, all with random weights
+	std::vector<NeuralNetwork*> brains;
+	for (int mode = MODE1; mode <= MODE4; mode++) brains.push_back(new NeuralNetwork(networkLayers(mode)));
+	std::vector<NeuralNetwork*> batch;
+	for (size_t network = 0; network < batchSize; network++) batch.push_back(new NeuralNetwork(networkLayers(MODE1)));
+	RandomStream random(options.seed, RandomPurpose::rpBrain);
+	for (NeuralNetwork* brain : brains)
+		for (float& weight : brain->genome()) weight = (random.nextFloat() * 2.0f) - 1.0f;
+	for (NeuralNetwork* brain : batch)
+		for (float& weight : brain->genome()) weight = (random.nextFloat() * 2.0f) - 1.0f;
+
+	// Inputs for each brain, and what's fed to the sigmoid and sinCos on their own
+	std::vector<float> inputs(numInputSets * 16);
+	for (float& input : inputs) input = random.nextFloat();
+	std::vector<float> sigmoidInputs(4096), angles(4096);
+	for (size_t index = 0; index < sigmoidInputs.size(); index++) {
+		sigmoidInputs[index] = (random.nextFloat() * 200.0f) - 100.0f;
+		angles[index] = (random.nextFloat() * 16384.0f) - 8192.0f;
+	}
+
+	// Sets the inputs of a brain from one of the input sets
+	auto setInputs = [&inputs](NeuralNetwork* brain, const size_t numInputs, const size_t set) {
+		for (size_t input = 0; input < numInputs; input++) brain->setInput(input, inputs[(set * 16) + input]);
+	};
+
+	// The scalar answers everything else is checked against
+	SimdKernels::select(SimdLevel::slScalar);
+	std::vector<std::vector<float>> expected(brains.size());
+	for (size_t mode = 0; mode < brains.size(); mode++) {
+		const std::vector<size_t> layers = networkLayers((int)mode + MODE1);
+		for (size_t set = 0; set < numInputSets; set++) {
+			setInputs(brains[mode], layers[0], set);
+			brains[mode]->update();
+			for (size_t output = 0; output < layers.back(); output++) expected[mode].push_back(brains[mode]->value(output));
+		}
+	}
+	const size_t batchInputs = networkLayers(MODE1)[0];
+	const size_t batchOutputs = networkLayers(MODE1).back();
+	std::vector<float> expectedBatch;
+	for (size_t network = 0; network < batchSize; network++) {
+		setInputs(batch[network], batchInputs, network % numInputSets);
+		batch[network]->update();
+		for (size_t output = 0; output < batchOutputs; output++) expectedBatch.push_back(batch[network]->value(output));
+	}
+	std::vector<float> expectedSigmoid = sigmoidInputs;
+	SimdKernels::sigmoid(expectedSigmoid.data(), expectedSigmoid.size());
+
+	// Number of neurons (not counting the inputs) in the MODE4 brain, which is the one timed
+	size_t neurons = 0;
+	const std::vector<size_t> timedLayers = networkLayers(MODE4);
+	for (size_t layer = 1; layer < timedLayers.size(); layer++) neurons += timedLayers[layer];
+	size_t batchNeurons = 0;
+	for (size_t layer = 1; layer < networkLayers(MODE1).size(); layer++) batchNeurons += networkLayers(MODE1)[layer] * batchSize;
+
+	printf("Instruction set  Brain error  Batch error  Sigmoid error  sinCos error  update() neurons/s  Batch neurons/s  Sigmoid values/s  sinCos values/s\n");
+	NeuralNetwork::Batch work;
+	std::vector<float> values(sigmoidInputs.size()), sines(angles.size()), cosines(angles.size());
+	for (const SimdLevel level : levels) {
+		if (level > best) {
+			printf("%15s  not supported by this CPU\n", simdLevelName(level));
+			continue;
+		}
+		SimdKernels::select(level);
+
+		// Largest difference from the scalar brains, one at a time and in a batch
+		float brainError = 0;
+		for (size_t mode = 0; mode < brains.size(); mode++) {
+			const std::vector<size_t> layers = networkLayers((int)mode + MODE1);
+			for (size_t set = 0; set < numInputSets; set++) {
+				setInputs(brains[mode], layers[0], set);
+				brains[mode]->update();
+				for (size_t output = 0; output < layers.back(); output++)
+					brainError = std::max(brainError, fabsf(brains[mode]->value(output) - expected[mode][(set * layers.back()) + output]));
+			}
+		}
+		for (size_t network = 0; network < batchSize; network++) setInputs(batch[network], batchInputs, network % numInputSets);
+		NeuralNetwork::updateBatch(batch.data(), batch.size(), work);
+		float batchError = 0;
+		for (size_t network = 0; network < batchSize; network++)
+			for (size_t output = 0; output < batchOutputs; output++)
+				batchError = std::max(batchError, fabsf(batch[network]->value(output) - expectedBatch[(network * batchOutputs) + output]));
+
+		// The sigmoid on its own over -100 to 100, and sinCos against double precision
+		values = sigmoidInputs;
+		SimdKernels::sigmoid(values.data(), values.size());
+		float sigmoidError = 0;
+		for (size_t index = 0; index < values.size(); index++) sigmoidError = std::max(sigmoidError, fabsf(values[index] - expectedSigmoid[index]));
+		SimdKernels::sinCos(angles.data(), sines.data(), cosines.data(), angles.size());
+		double sinCosError = 0;
+		for (size_t index = 0; index < angles.size(); index++) {
+			sinCosError = std::max(sinCosError, fabs(sines[index] - sin((double)angles[index])));
+			sinCosError = std::max(sinCosError, fabs(cosines[index] - cos((double)angles[index])));
+		}
+
+		// Speed
+		NeuralNetwork* timed = brains[MODE4 - MODE1];
+		const double updates = timesPerSecond([timed]() { timed->update(); });
+		const double batches = timesPerSecond([&batch, &work]() { NeuralNetwork::updateBatch(batch.data(), batch.size(), work); });
+		const double sigmoids = timesPerSecond([&values]() { SimdKernels::sigmoid(values.data(), values.size()); });
+		const double sinCoses = timesPerSecond([&angles, &sines, &cosines]() { SimdKernels::sinCos(angles.data(), sines.data(), cosines.data(), angles.size()); });
+
+		const bool ok = (brainError <= SIMD_SIGMOID_TOLERANCE) && (batchError <= SIMD_SIGMOID_TOLERANCE) && (sigmoidError <= SIMD_SIGMOID_TOLERANCE) &&
+			(sinCosError <= SIMD_SINCOS_TOLERANCE);
+		printf("%15s  %11.2e  %11.2e  %13.2e  %12.2e  %18.0f  %15.0f  %16.0f  %15.0f%s\n", simdLevelName(level), brainError, batchError, sigmoidError,
+			sinCosError, updates * neurons, batches * batchNeurons, sigmoids * values.size(), sinCoses * angles.size(), ok ? "" : "  FAILED");
+		fflush(stdout);
+		if (!ok) passed = false;
+	}
+	SimdKernels::select(best);
+
+	for (NeuralNetwork* brain : brains) delete brain;
+	for (NeuralNetwork* brain : batch) delete brain;
+	printf("\nThe errors are the largest difference from the scalar kernels (sinCos from double precision).  The limits are %.1e and %.1e\n",
+		SIMD_SIGMOID_TOLERANCE, SIMD_SINCOS_TOLERANCE);
+	return passed;
+}
+
+// Measures the accuracy and speed of each activation function.  The error is the largest difference from the exact function
+// (in double precision) over -100 to 100.  The speed is applied to 14 neuron layers, as in the brains, with each set of kernels
+static bool runActivations(const BenchmarkOptions&) {
+	struct ActivationInfo {
+		ActivationFunction function;
+		const char* name;
+		double (*exact)(double x);
+	};
+	static const ActivationInfo activations[] = {
+		{ ActivationFunction::afSigmoid, "afSigmoid", [](double x) { return 1.0 / (1.0 + exp(-x)); } },
+		{ ActivationFunction::afSigmoidLUT, "afSigmoidLUT", [](double x) { return 1.0 / (1.0 + exp(-x)); } },
+		{ ActivationFunction::afSigmoidRational, "afSigmoidRational", [](double x) { return 1.0 / (1.0 + exp(-x)); } },
+		{ ActivationFunction::afSigmoidPolynomial, "afSigmoidPolynomial", [](double x) { return 1.0 / (1.0 + exp(-x)); } },
+		{ ActivationFunction::afTanh, "afTanh", [](double x) { return tanh(x); } },
+		{ ActivationFunction::afReLU, "afReLU", [](double x) { return x > 0 ? x : 0.0; } },
+		{ ActivationFunction::afLeakyReLU, "afLeakyReLU", [](double x) { return x > 0 ? x : x * 0.01; } }
+	};
+	const size_t layerSize = 14;
+	const SimdLevel best = SimdKernels::detect();
+	const SimdLevel levels[] = { SimdLevel::slScalar, SimdLevel::slAVX2, SimdLevel::slAVX512 };
+
+	// Every float step of 1/10000 from -100 to 100 for the error, and a block of layers in the same range for the speed
+	std::vector<float> points, values;
+	for (int step = -1000000; step <= 1000000; step++) points.push_back((float)step / 10000.0f);
+	std::vector<float> layers(layerSize * 1024);
+	for (size_t index = 0; index < layers.size(); index++) layers[index] = points[(index * 7919) % points.size()];
+	std::vector<float> work(layers.size());
+
+	printf("Activation            Largest error  Scalar values/s  AVX2 values/s  AVX-512 values/s\n");
+	for (const ActivationInfo& activation : activations) {
+		values = points;
+		Activation::apply(activation.function, values.data(), values.size());
+		double error = 0;
+		for (size_t index = 0; index < points.size(); index++)
+			error = std::max(error, fabs((double)values[index] - activation.exact((double)points[index])));
+
+		// Levels the CPU doesn't have are shown as 0
+		double speed[3] = { 0, 0, 0 };
+		for (int level = 0; level < 3; level++) {
+			if (levels[level] > best) continue;
+			SimdKernels::select(levels[level]);
+			speed[level] = timesPerSecond([&]() {
+				work = layers;
+				for (size_t layer = 0; layer < work.size(); layer += layerSize) Activation::apply(activation.function, work.data() + layer, layerSize);
+			}) * layers.size();
+		}
+		SimdKernels::select(best);
+		printf("%-20s  %13.2e  %15.0f  %13.0f  %16.0f\n", activation.name, error, speed[0], speed[1], speed[2]);
+		fflush(stdout);
+	}
+	return true;
+}
+
+// Compares a StaticNetwork with the NeuralNetwork it stands in for.  Both get the same genome and inputs.  With the scalar
+// kernels they sum in the same order so have to give exactly the same outputs, with the others they have to agree within
+// SIMD_SIGMOID_TOLERANCE.  Then both are timed.  Returns FALSE if they don't agree
+template<typename Static>
+static bool compareNetworks(const int mode, const BenchmarkOptions& options) {
+	const std::vector<size_t> layers = networkLayers(mode);
+	if (Static::layers() != layers) {
+		printf("%4i  StaticNetwork is a different shape to the brain  FAILED\n", mode);
+		return false;
+	}
+	const size_t numInputSets = 256;
+	const SimdLevel best = SimdKernels::detect();
+
+	NeuralNetwork dynamic(layers);
+	Static* fixed = new Static();
+	RandomStream random(options.seed, RandomPurpose::rpBrain, (uint64_t)mode);
+	for (float& weight : dynamic.genome()) weight = (random.nextFloat() * 2.0f) - 1.0f;
+	std::vector<float> genome;
+	dynamic.getWeights(genome);
+	fixed->setWeights(genome);
+	std::vector<float> inputs(numInputSets * layers[0]);
+	for (float& input : inputs) input = random.nextFloat();
+
+	// Largest difference between the two with the scalar kernels and then the best ones
+	float error[2] = { 0, 0 };
+	const SimdLevel levels[2] = { SimdLevel::slScalar, best };
+	for (int level = 0; level < 2; level++) {
+		SimdKernels::select(levels[level]);
+		for (size_t set = 0; set < numInputSets; set++) {
+			for (size_t input = 0; input < layers[0]; input++) {
+				dynamic.setInput(input, inputs[(set * layers[0]) + input]);
+				fixed->setInput(input, inputs[(set * layers[0]) + input]);
+			}
+			dynamic.update();
+			fixed->update();
+			for (size_t output = 0; output < layers.back(); output++)
+				error[level] = std::max(error[level], fabsf(dynamic.value(output) - fixed->value(output)));
+		}
+	}
+
+	size_t neurons = 0;
+	for (size_t layer = 1; layer < layers.size(); layer++) neurons += layers[layer];
+	const double dynamicSpeed = timesPerSecond([&dynamic]() { dynamic.update(); }) * neurons;
+	const double staticSpeed = timesPerSecond([fixed]() { fixed->update(); }) * neurons;
+	delete fixed;
+
+	const bool ok = (error[0] == 0.0f) && (error[1] <= SIMD_SIGMOID_TOLERANCE);
+	char shape[64] = "";
+	for (size_t layer = 0; layer < layers.size(); layer++)
+		snprintf(shape + strlen(shape), sizeof(shape) - strlen(shape), layer ? ",%zu" : "%zu", layers[layer]);
+	printf("%4i  %-14s  %12.2e  %12.2e  %19.0f  %21.0f  %7.2fx%s\n", mode, shape, error[0], error[1], dynamicSpeed, staticSpeed,
+		staticSpeed / dynamicSpeed, ok ? "" : "  FAILED");
+	fflush(stdout);
+	return ok;
+}
+
+// StaticNetwork against NeuralNetwork::update() for each experiment's brain
+static bool runNetworks(const BenchmarkOptions& options) {
+	printf("Mode  Layers          Scalar error  %s error  NeuralNetwork neurons/s  StaticNetwork neurons/s  Speed up\n", simdLevelName(SimdKernels::detect()));
+	bool passed = compareNetworks<StaticNetwork<5, 14, 12, 2>>(MODE1, options);
+	passed &= compareNetworks<StaticNetwork<8, 14, 12, 2>>(MODE2, options);
+	passed &= compareNetworks<StaticNetwork<8, 14, 12, 2>>(MODE3, options);
+	passed &= compareNetworks<StaticNetwork<9, 16, 14, 10, 4>>(MODE4, options);
+	SimdKernels::select(SimdKernels::detect());
+	printf("\nThe errors are the largest difference between the two.  Both use the activation kernels for the instruction set\n");
+	return passed;
+}
+
+// Checks that once the first generations have sized everything, stepping and producing the next generation don't allocate
+// any memory.  Each experiment is run at two population sizes, two generations to warm up and then three that are counted
+static bool runAllocations(const BenchmarkOptions& options) {
+	const int populationSizes[] = { POPULATION_SIZE, 1000 };
+	const int warmUpGenerations = 2;
+	const int countedGenerations = 3;
+	bool passed = true;
+
+	printf("Mode  Lifeforms  Steps counted  Allocations stepping  Allocations producing generations\n");
+	for (int mode = MODE1; mode <= MODE4; mode++) {
+		for (const int populationSize : populationSizes) {
+			if (options.maxPopulation && (populationSize > options.maxPopulation)) continue;
+			WorldSettings world;
+			world.populationSize = populationSize;
+			world.numCells = defaultCells(mode);
+			Experiment* simulation = createExperiment(mode, options.seed, world);
+
+			size_t stepAllocations = 0, generationAllocations = 0;
+			long long steps = 0;
+			for (int generation = 0; generation < warmUpGenerations + countedGenerations; generation++) {
+				const bool counted = generation >= warmUpGenerations;
+				size_t before = g_allocations;
+				while (simulation->step()) if (counted) steps++;
+				if (counted) stepAllocations += g_allocations - before;
+
+				before = g_allocations;
+				GenStatistics stats;
+				simulation->produceNextGeneration(stats);
+				if (counted) generationAllocations += g_allocations - before;
+			}
+			delete simulation;
+
+			const bool ok = (stepAllocations == 0) && (generationAllocations == 0);
+			printf("%4i  %9i  %13lli  %20zu  %33zu%s\n", mode, populationSize, steps, stepAllocations, generationAllocations, ok ? "" : "  FAILED");
+			fflush(stdout);
+			if (!ok) passed = false;
+		}
+	}
+	return passed;
+}
+
+// Times producing a generation with each way of picking parents, from 30 to 1,000,000 genomes.  The brains are as small as
+// they can be (one weight each) so picking the parents is most of the work.  Sorting the population is included as every
+// method needs it.  The roulette is O(n) per pick, so it stops at 100,000 where a generation already takes seconds
+static bool runSelection(const BenchmarkOptions& options) {
+	struct MethodInfo {
+		SelectionMethod method;
+		const char* name;
+		int maxPopulation;
+	};
+	static const MethodInfo methods[] = {
+		{ SelectionMethod::smRoulette, "smRoulette", 100000 },
+		{ SelectionMethod::smPrefixSum, "smPrefixSum", 1000000 },
+		{ SelectionMethod::smAlias, "smAlias", 1000000 },
+		{ SelectionMethod::smStochasticUniversal, "smStochasticUniversal", 1000000 }
+	};
+	static const int populationSizes[] = { 30, 100, 300, 1000, 3000, 10000, 30000, 100000, 300000, 1000000 };
+	const int maxPopulation = options.maxPopulation ? options.maxPopulation : 1000000;
+
+	printf("Milliseconds to produce a generation\n\n Genomes");
+	for (const MethodInfo& method : methods) printf("  %21s", method.name);
+	printf("\n");
+
+	for (const int populationSize : populationSizes) {
+		if (populationSize > maxPopulation) break;
+		std::vector<NetworkWeightFitness> generation(populationSize);
+		RandomStream random(options.seed, RandomPurpose::rpSelection);
+
+		printf("%8i", populationSize);
+		for (const MethodInfo& method : methods) {
+			if (populationSize > method.maxPopulation) {
+				printf("  %21s", "-");
+				continue;
+			}
+			// The brains end up using the genetic algorithm's storage, so each method needs its own
+			GeneticAlgorithm* ga = new GeneticAlgorithm(NUM_ALPHAS, 0.7f, 0.1f, 0.3f, method.method);
+			ga->setSeed(options.seed);
+			std::vector<NeuralNetwork*> brains;
+			for (int brain = 0; brain < populationSize; brain++) brains.push_back(new NeuralNetwork({ 1, 1 }));
+
+			// Fresh fitness values each time, as the sort would be quicker on ones it had already sorted.  The first
+			// generation moves the genomes into the pool so isn't timed
+			double seconds = 0;
+			int runs = -1;
+			while (seconds < 0.2) {
+				for (int brain = 0; brain < populationSize; brain++) generation[brain] = { brains[brain], random.nextFloat() * 3.0f };
+				const std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+				ga->produceNextGeneration(generation);
+				if (++runs > 0) seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			}
+			printf("  %21.3f", (seconds * 1000.0) / runs);
+			fflush(stdout);
+			for (NeuralNetwork* brain : brains) delete brain;
+			delete ga;
+		}
+		printf("\n");
+	}
+	return true;
+}
+
+// Steps per second with 1 to 64 threads, with 3,000 lifeforms unless --max says otherwise.  With DETERMINISTIC_STEPPING
+// every thread count has to end the generation with the same results
+static bool runThreads(const BenchmarkOptions& options) {
+#ifdef THREADDED
+	static const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+	const int populationSize = options.maxPopulation ? options.maxPopulation : 3000;
+	bool passed = true;
+	double baseline = 0;
+	GenStatistics expected;
+
+	printf("Mode %i, %i lifeforms, %i steps, %u CPU cores\n\n", options.mode, populationSize, options.numSteps, std::thread::hardware_concurrency());
+	printf("Threads   Steps/s  Lifeform steps/s  Speed up\n");
+	for (const int numThreads : threadCounts) {
+		WorldSettings world = scaledWorld(options.mode, populationSize);
+		world.numThreads = numThreads;
+		Experiment* simulation = createExperiment(options.mode, options.seed, world);
+
+		int stepsRun = 0;
+		const std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+		while ((stepsRun < options.numSteps) && (simulation->step())) stepsRun++;
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		GenStatistics stats;
+		simulation->produceNextGeneration(stats);
+		delete simulation;
+
+		const double stepsPerSecond = seconds > 0 ? stepsRun / seconds : 0;
+		if (numThreads == 1) {
+			baseline = stepsPerSecond;
+			expected = stats;
+		}
+		bool ok = true;
+#ifdef DETERMINISTIC_STEPPING
+		ok = (stats.numSurvivors == expected.numSurvivors) && (stats.numIterations == expected.numIterations) && (stats.totalFitness == expected.totalFitness);
+#endif
+		printf("%7i  %8.1f  %16.0f  %7.2fx%s\n", numThreads, stepsPerSecond, stepsPerSecond * populationSize, baseline > 0 ? stepsPerSecond / baseline : 0,
+			ok ? "" : "  FAILED, different results to 1 thread");
+		fflush(stdout);
+		if (!ok) passed = false;
+	}
+	return passed;
+#else
+	(void)options;
+	printf("Built without THREADDED\n");
+	return true;
+#endif
+}
+
+// Nearest battery lookups a second with the SIMD scan over every battery (SIMD_RESOURCE_SCAN) against searching the
+// spatial grid ring by ring (SPATIAL_GRID), from 10 to 100,000 batteries.  The world grows so they're as far apart as in
+// the normal world.  Both have to find the same battery, and it reports the count where the grid starts winning
+static bool runResources(const BenchmarkOptions& options) {
+	static const int resourceCounts[] = { 10, 30, 100, 300, 1000, 3000, 10000, 30000, 100000 };
+	const int maxResources = options.maxPopulation ? options.maxPopulation : 100000;
+	const int radius = (int)(0.012f * (SIMULATION_WIDTH < SIMULATION_HEIGHT ? SIMULATION_WIDTH : SIMULATION_HEIGHT));
+	const size_t numQueries = 1024;
+	bool passed = true;
+	int crossover = 0;
+
+	printf("Mode %i spacing, battery radius %i, %s scan\n\n", options.mode, radius, simdLevelName(SimdKernels::detect()));
+	printf("Batteries          World  Cell size  Scan lookups/s  Grid lookups/s  Grid speed up\n");
+	for (const int numResources : resourceCounts) {
+		if (numResources > maxResources) break;
+
+		// Batteries anywhere, and the points to look from
+		const double scale = sqrt((double)numResources / defaultCells(options.mode));
+		const int width = scale > 1.0 ? (int)(SIMULATION_WIDTH * scale) : SIMULATION_WIDTH;
+		const int height = scale > 1.0 ? (int)(SIMULATION_HEIGHT * scale) : SIMULATION_HEIGHT;
+		if (!ResourceTable::canScan(width, height)) break;
+		RandomStream random(options.seed, RandomPurpose::rpWorld);
+		std::vector<FloatPair> resources(numResources), queries(numQueries);
+		for (FloatPair& position : resources) position = { random.nextFloat() * width, random.nextFloat() * height };
+		for (FloatPair& position : queries) position = { random.nextFloat() * width, random.nextFloat() * height };
+
+		// The same cell size the simulation would pick
+		const double spacing = sqrt(((double)width * (double)height) / numResources);
+		const int smallest = width < height ? width : height;
+		const int cellSize = spacing <= GRID_CELL_SIZE ? GRID_CELL_SIZE : (spacing < smallest ? (int)spacing : smallest);
+
+		ResourceTable table;
+		SpatialGrid grid(width, height, cellSize);
+		for (int index = 0; index < numResources; index++) {
+			table.add(resources[index].x, resources[index].y, radius * radius, 0);
+			grid.insert(index, resources[index].x, resources[index].y);
+		}
+
+		auto scanNearest = [&](const FloatPair& position) {
+			int32_t nearestIndex, nearestDistance, secondDistance;
+			table.nearest(position.x, position.y, width, height, 1, &nearestIndex, &nearestDistance, &secondDistance);
+			return nearestIndex;
+		};
+
+		// The same search findDirectionToResources() does, for the one type
+		const float gridCell = grid.cellWidth() < grid.cellHeight() ? grid.cellWidth() : grid.cellHeight();
+		auto gridNearest = [&](const FloatPair& position) {
+			int nearestIndex = -1;
+			int64_t nearestValue = 0;
+			auto consider = [&](const int index) {
+				int64_t distanceX = (int64_t)std::abs(position.x - (int)resources[index].x);
+				int64_t distanceY = (int64_t)std::abs(position.y - (int)resources[index].y);
+				if (distanceX > width / 2) distanceX = width - distanceX;
+				if (distanceY > height / 2) distanceY = height - distanceY;
+				int64_t distance = ((distanceX * distanceX) + (distanceY * distanceY)) - (radius * radius);
+				if (distance < 0) distance = 0;
+				if ((nearestIndex == -1) || (distance < nearestValue) || ((distance == nearestValue) && (index < nearestIndex))) {
+					nearestIndex = index;
+					nearestValue = distance;
+				}
+			};
+			for (int ring = 0; ring < grid.numRings(); ring++) {
+				const int64_t reach = (int64_t)((ring - 1) * gridCell) - 2;
+				if ((reach > 0) && (nearestIndex >= 0) && (nearestValue < (reach * reach) - (radius * radius))) break;
+				grid.forEachInRing(position.x, position.y, ring, consider);
+			}
+			return nearestIndex;
+		};
+
+		int mismatches = 0;
+		for (const FloatPair& position : queries)
+			if (scanNearest(position) != gridNearest(position)) mismatches++;
+
+		volatile int found = 0;		// So the lookups can't be optimised away
+		const double scanRate = timesPerSecond([&]() {
+			for (const FloatPair& position : queries) found = scanNearest(position);
+		}) * numQueries;
+		const double gridRate = timesPerSecond([&]() {
+			for (const FloatPair& position : queries) found = gridNearest(position);
+		}) * numQueries;
+		if ((gridRate > scanRate) && (!crossover)) crossover = numResources;
+
+		char worldSize[32];
+		snprintf(worldSize, sizeof(worldSize), "%ix%i", width, height);
+		printf("%9i  %13s  %9i  %14.0f  %14.0f  %12.2fx", numResources, worldSize, cellSize, scanRate, gridRate, gridRate / scanRate);
+		if (mismatches) printf("  FAILED, %i of %zu lookups found a different battery", mismatches, numQueries);
+		printf("\n");
+		fflush(stdout);
+		if (mismatches) passed = false;
+	}
+
+	if (crossover) printf("\nThe grid is faster from %i batteries\n", crossover);
+	else printf("\nThe scan was faster at every size\n");
+	return passed;
+}
+
+// Checks FreeSpace picks places as evenly as trying random points until one is clear, which is what getRandomPosition()
+// did before FREE_SPACE_SAMPLER.  Both samplers fill the same bins over the normal world's placing area, and a chi-square
+// test says whether the two sets of counts could have come from the same spread.  Also times each of them, retrying being
+// how many random points until one is clear
+static bool runFreeSpace(const BenchmarkOptions& options) {
+	struct Circle {
+		float x, y;
+		int radius;
+	};
+	struct Layout {
+		const char* name;
+		int numBatteries;
+		bool obstacles;			// The sunlight and quicksand of MODE2 and MODE3
+	};
+	static const Layout layouts[] = {
+		{ "Empty", 0, false },
+		{ "Normal world", 20, true },
+		{ "1,000 batteries", 1000, true }
+	};
+	const int numSamples = 200000;
+	const int numBins = 12;			// Along each side
+	const float left = SIMULATION_WIDTH * 0.1f, across = SIMULATION_WIDTH * 0.8f;
+	const float top = SIMULATION_HEIGHT * 0.1f, down = SIMULATION_HEIGHT * 0.8f;
+	const int screenSize = SIMULATION_WIDTH < SIMULATION_HEIGHT ? SIMULATION_WIDTH : SIMULATION_HEIGHT;
+	bool passed = true;
+
+	printf("%i samples each into %ix%i bins\n\n", numSamples, numBins, numBins);
+	printf("Layout            Free  Chi-square  Degrees  Limit  Retrying/s  FreeSpace/s\n");
+	for (const Layout& layout : layouts) {
+		RandomStream random(options.seed, RandomPurpose::rpWorld);
+		std::vector<Circle> circles;
+		if (layout.obstacles) {
+			circles.push_back({ 0.3f * SIMULATION_WIDTH, 0.2f * SIMULATION_HEIGHT, (int)(0.1f * screenSize) });
+			circles.push_back({ 0.9f * SIMULATION_WIDTH, 0.9f * SIMULATION_HEIGHT, (int)(0.2f * screenSize) });
+			for (int sand = 0; sand < 3; sand++)
+				circles.push_back({ 0.5f * SIMULATION_WIDTH, (0.3f + (0.2f * sand)) * SIMULATION_HEIGHT, (int)(0.15f * screenSize) });
+		}
+		for (int battery = 0; battery < layout.numBatteries; battery++)
+			circles.push_back({ left + (across * random.nextFloat()), top + (down * random.nextFloat()), (int)(0.012f * screenSize) });
+
+		FreeSpace freeSpace(left, top, across, down, FREE_SPACE_CELL_SIZE);
+		for (size_t index = 0; index < circles.size(); index++)
+			freeSpace.add((int)index, circles[index].x, circles[index].y, circles[index].radius);
+
+		// The same test as Simulation::resourceContains()
+		auto isInside = [&circles](const int index, const float x, const float y) {
+			const int64_t distanceX = (int64_t)(x - circles[index].x);
+			const int64_t distanceY = (int64_t)(y - circles[index].y);
+			return sqrt((double)((distanceX * distanceX) + (distanceY * distanceY))) <= circles[index].radius;
+		};
+		auto isClear = [&](const float x, const float y) {
+			for (size_t index = 0; index < circles.size(); index++)
+				if (isInside((int)index, x, y)) return false;
+			return true;
+		};
+		auto binOf = [&](const float x, const float y) {
+			const int column = std::min((int)(((x - left) / across) * numBins), numBins - 1);
+			const int row = std::min((int)(((y - top) / down) * numBins), numBins - 1);
+			return (row * numBins) + column;
+		};
+
+		int tries = 0, outside = 0;
+		float x, y;
+		auto trySample = [&]() {
+			do {
+				x = left + (across * random.nextFloat());
+				y = top + (down * random.nextFloat());
+				tries++;
+			} while (!isClear(x, y));
+		};
+		auto freeSpaceSample = [&]() {
+			if (!freeSpace.sample(random, x, y, [&](const int index) { return isInside(index, x, y); })) outside++;
+			else if (!isClear(x, y)) outside++;
+		};
+
+		std::vector<int> triedCounts(numBins * numBins, 0), freeSpaceCounts(numBins * numBins, 0);
+		for (int sample = 0; sample < numSamples; sample++) {
+			trySample();
+			triedCounts[binOf(x, y)]++;
+			freeSpaceSample();
+			freeSpaceCounts[binOf(x, y)]++;
+		}
+		const double freeFraction = (double)numSamples / tries;
+
+		// Two sample chi-square over the bins either of them reached.  The limit is about 5 standard deviations above
+		// what it should average, so a deterministic run only fails if the spreads really are different
+		double chiSquare = 0;
+		int degrees = -1;
+		for (int bin = 0; bin < numBins * numBins; bin++) {
+			const int total = triedCounts[bin] + freeSpaceCounts[bin];
+			if (!total) continue;
+			const double difference = (double)triedCounts[bin] - freeSpaceCounts[bin];
+			chiSquare += (difference * difference) / total;
+			degrees++;
+		}
+		const double limit = degrees + (5.0 * sqrt(2.0 * degrees));
+		const bool ok = (chiSquare <= limit) && (!outside);
+
+		const double triesPerSecond = timesPerSecond(trySample);
+		const double freeSpacePerSecond = timesPerSecond(freeSpaceSample);
+		printf("%-16s  %3.0f%%  %10.1f  %7i  %5.0f  %10.0f  %11.0f", layout.name, freeFraction * 100.0, chiSquare, degrees, limit,
+			triesPerSecond, freeSpacePerSecond);
+		if (outside) printf("  FAILED, %i samples weren't in free space", outside);
+		else if (!ok) printf("  FAILED, the spreads are different");
+		printf("\n");
+		fflush(stdout);
+		if (!ok) passed = false;
+	}
+	return passed;
+}
+
+// Checks a snapshot only loads into an experiment whose brains are the same shape, so the weights can't end up in the wrong
+// places.  Each experiment's snapshot is loaded into every experiment, and so are snapshots in the older format without the
+// shape, including one from before MODE4 had 9 inputs.  One that loads has to save the same weights again
+static bool runSnapshots(const BenchmarkOptions& options) {
+	const std::wstring filename = L"ga1benchmark_snapshot.dat";
+	const std::wstring resaved = L"ga1benchmark_resaved.dat";
+	const unsigned int savedGeneration = 7;
+	bool passed = true;
+
+	// The weights at the end of a snapshot
+	auto readWeights = [](const std::wstring& name, const size_t count) {
+		std::vector<float> weights(count);
+		FILE* file = fopen(std::string(name.begin(), name.end()).c_str(), "rb");
+		if (!file) return std::vector<float>();
+		if ((fseek(file, -(long)(count * sizeof(float)), SEEK_END)) || (fread(weights.data(), sizeof(float), count, file) != count)) weights.clear();
+		fclose(file);
+		return weights;
+	};
+
+	// Try loading the snapshot into each experiment.  It should only load into the ones with brains shaped like 'layers'
+	auto tryLoading = [&](const char* name, const std::vector<size_t>& layers) {
+		size_t genomeSize = 0;
+		for (size_t layer = 1; layer < layers.size(); layer++) genomeSize += layers[layer] * (layers[layer - 1] + 1);
+		const std::vector<float> saved = readWeights(filename, genomeSize * POPULATION_SIZE);
+
+		printf("%-22s", name);
+		for (int mode = MODE1; mode <= MODE4; mode++) {
+			const bool shouldLoad = brainLayers(mode) == layers;
+			Experiment* simulation = createExperiment(mode, options.seed);
+			unsigned int generation = 0;
+			GenStatistics stats;
+			bool loaded = simulation->loadSnapshot(filename, generation, stats);
+			bool ok = loaded == shouldLoad;
+			if (loaded && ok) {
+				ok = (generation == savedGeneration) && (simulation->saveSnapshot(resaved, generation, stats)) &&
+					(readWeights(resaved, saved.size()) == saved);
+			}
+			delete simulation;
+			printf("  %-9s", ok ? (loaded ? "loaded" : "rejected") : (loaded ? "WRONG" : "FAILED"));
+			if (!ok) passed = false;
+		}
+		printf("\n");
+	};
+
+	printf("Snapshot                  Mode 1     Mode 2     Mode 3     Mode 4\n");
+	for (int mode = MODE1; mode <= MODE4; mode++) {
+		Experiment* simulation = createExperiment(mode, options.seed);
+		const bool saved = simulation->saveSnapshot(filename, savedGeneration, GenStatistics());
+		delete simulation;
+		char name[32];
+		snprintf(name, sizeof(name), "Mode %i", mode);
+		if (saved) tryLoading(name, brainLayers(mode));
+		else {
+			printf("%-22s  FAILED, couldn't save it\n", name);
+			passed = false;
+		}
+	}
+
+	// The older format was the generation, its statistics, the number of weights in a brain and then the weights
+	struct OldSnapshot {
+		const char* name;
+		std::vector<size_t> layers;
+	};
+	const OldSnapshot oldSnapshots[] = {
+		{ "Old mode 1", brainLayers(MODE1) },
+		{ "Old mode 2 and 3", brainLayers(MODE2) },
+		{ "Old mode 4, 7 inputs", { 7, 16, 14, 10, 4 } },
+		{ "Old mode 4, 9 inputs", brainLayers(MODE4) }
+	};
+	RandomStream random(options.seed, RandomPurpose::rpBrain);
+	for (const OldSnapshot& old : oldSnapshots) {
+		unsigned int total = 0;
+		for (size_t layer = 1; layer < old.layers.size(); layer++) total += (unsigned int)(old.layers[layer] * (old.layers[layer - 1] + 1));
+		std::vector<float> weights(total * POPULATION_SIZE);
+		for (float& weight : weights) weight = (random.nextFloat() * 2.0f) - 1.0f;
+		const GenStatistics stats;
+
+		FILE* file = fopen(std::string(filename.begin(), filename.end()).c_str(), "wb");
+		if (!file) return false;
+		fwrite(&savedGeneration, sizeof(savedGeneration), 1, file);
+		fwrite(&stats, sizeof(stats), 1, file);
+		fwrite(&total, sizeof(total), 1, file);
+		fwrite(weights.data(), sizeof(float), weights.size(), file);
+		fclose(file);
+		tryLoading(old.name, old.layers);
+	}
+
+	// Without any lifeforms there's nothing to load it into
+	WorldSettings empty;
+	empty.populationSize = 0;
+	Experiment* simulation = createExperiment(MODE4, options.seed, empty);
+	unsigned int generation = 0;
+	GenStatistics stats;
+	const bool loaded = simulation->loadSnapshot(filename, generation, stats);
+	delete simulation;
+	printf("%-22s  %s\n", "No lifeforms", loaded ? "WRONG" : "rejected");
+	if (loaded) passed = false;
+
+	remove(std::string(filename.begin(), filename.end()).c_str());
+	remove(std::string(resaved.begin(), resaved.end()).c_str());
+	return passed;
+}
+
+// A named measurement
+struct BenchmarkSuite {
+	const char* name;
+	const char* description;
+	bool (*run)(const BenchmarkOptions& options);
+};
+
+static const BenchmarkSuite g_suites[] = {
+	{ "scaling", "Memory and steps per second from 30 to 100,000 lifeforms (the default)", runScaling },
+	{ "kernels", "Checks the SIMD kernels agree with the scalar ones and times each instruction set", runKernels },
+	{ "activations", "Accuracy and speed of each activation function", runActivations },
+	{ "networks", "StaticNetwork against NeuralNetwork for each experiment's brain", runNetworks },
+	{ "allocations", "Checks stepping and producing generations don't allocate once warmed up", runAllocations },
+	{ "selection", "Time to produce a generation with each way of picking parents, 30 to 1,000,000 genomes", runSelection },
+	{ "threads", "Steps per second with 1 to 64 threads", runThreads },
+	{ "freespace", "Checks the free space map picks places as evenly as trying random points", runFreeSpace },
+	{ "snapshots", "Checks snapshots only load into experiments with the same shape of brain", runSnapshots },
+	{ "resources", "Nearest battery lookups with the SIMD scan against the spatial grid, 10 to 100,000 batteries", runResources },
+};
+
+static void showUsage(const char* program) {
+	printf("Usage: %s [options] [suite]\n", program);
+	printf("  -m, --mode N          Experiment to run, 1 to 4 (default %i)\n", EXPERIMENT_MODE);
+	printf("  -n, --steps N         Steps to time at each size (default 100)\n");
+	printf("      --max N           Largest population, or number of batteries for resources, to try (default 100000,\n");
+	printf("                        1000000 for selection, threads uses 3000)\n");
+	printf("  -s, --seed N          Seed for the simulations (default 1)\n");
+	printf("Suites:\n");
+	for (const BenchmarkSuite& suite : g_suites) printf("  %-20s  %s\n", suite.name, suite.description);
+}
+
+int main(int argc, char* argv[]) {
+	BenchmarkOptions options;
+	const BenchmarkSuite* suite = &g_suites[0];
+
+	for (int arg = 1; arg < argc; arg++) {
+		const char* name = argv[arg];
+		const bool hasValue = arg + 1 < argc;
+		const BenchmarkSuite* named = nullptr;
+		for (const BenchmarkSuite& candidate : g_suites)
+			if (!strcmp(name, candidate.name)) named = &candidate;
+
+		if ((!strcmp(name, "-m") || !strcmp(name, "--mode")) && hasValue) options.mode = atoi(argv[++arg]);
+		else if ((!strcmp(name, "-n") || !strcmp(name, "--steps")) && hasValue) options.numSteps = atoi(argv[++arg]);
+		else if (!strcmp(name, "--max") && hasValue) options.maxPopulation = atoi(argv[++arg]);
+		else if ((!strcmp(name, "-s") || !strcmp(name, "--seed")) && hasValue) options.seed = strtoull(argv[++arg], nullptr, 10);
+		else if (named) suite = named;
+		else {
+			showUsage(argv[0]);
+			return (!strcmp(name, "-h") || !strcmp(name, "--help")) ? 0 : 1;
+		}
+	}
+	if (defaultCells(options.mode) < 1) {
+		fprintf(stderr, "There is no experiment mode %i\n", options.mode);
+		return 1;
+	}
+	if (options.numSteps < 1) {
+		fprintf(stderr, "It needs at least one step to time\n");
+		return 1;
+	}
+
+	return suite->run(options) ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/*********************************************************************
+ * Neural Network with Genetic Algorithms Demonstration              *
+ * Copyright (C) 2002 RobSmithDev                                    *
+ * https://robsmithdev.co.uk                                         *
+ *                                                                   *
+ * For more information about this project please see the video at:  *
+ * https://www.youtube.com/watch?v=bq3FdlUeOTU                       *
+ *********************************************************************/
+
+// Runs the simulation from the command line without a window, as fast as it will go.
+// Any of the experiments can be picked when it's run, everything else is configured at the top of Simulation.h
+
+#include "Simulation.h"
+#include <chrono>
+#include <csignal>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Set by Ctrl+C, the run stops at the end of the current generation
+static volatile sig_atomic_t g_stopRequested = 0;
+
+static void onStopSignal(int) {
+	g_stopRequested = 1;
+}
+
+// Same file name the window uses when SAVE_DATA is defined
+static std::wstring snapshotFilename(const std::wstring& folder, const int mode, const unsigned int generation) {
+	return folder + L"/weights_" + std::to_wstring(mode) + L"_Generation_" + std::to_wstring(generation) + L".dat";
+}
+
+static void showUsage(const char* program) {
+	printf("Usage: %s [options]\n", program);
+	printf("  -m, --mode N          Experiment to run, 1 to 4 (default %i)\n", EXPERIMENT_MODE);
+	printf("                          1. Looking for Batteries\n");
+	printf("                          2. Looking for Solar Electricity and Batteries\n");
+	printf("                          3. Batteries and Quicksand\n");
+	printf("                          4. Batteries and Shields\n");
+	printf("  -p, --population N    Lifeforms in each generation (default %i)\n", POPULATION_SIZE);
+	printf("      --width N         Width of the world in pixels (default %i)\n", SIMULATION_WIDTH);
+	printf("      --height N        Height of the world in pixels (default %i)\n", SIMULATION_HEIGHT);
+	printf("  -c, --cells N         Batteries in the world (default depends on the mode)\n");
+	printf("  -t, --threads N       Threads to step the lifeforms with, 0 for one per CPU core (default %i)\n", THREAD_COUNT);
+	printf("  -g, --generations N   Number of generations to run (default 100)\n");
+	printf("  -s, --seed N          Seed for the simulation (default is the time)\n");
+	printf("  -o, --output FOLDER   Write a snapshot of each generation to FOLDER, as SAVE_DATA does\n");
+	printf("  -l, --load N          Carry on from the snapshot of generation N in the output folder\n");
+	printf("  -q, --quiet           Only show the totals at the end\n");
+}
+
+int main(int argc, char* argv[]) {
+	int mode = EXPERIMENT_MODE;
+	WorldSettings world;
+	unsigned int numGenerations = 100;
+	uint64_t seed = (uint64_t)time(NULL);
+	std::wstring outputFolder;
+	unsigned int loadGeneration = 0;
+	bool quiet = false;
+
+	for (int arg = 1; arg < argc; arg++) {
+		const char* name = argv[arg];
+		const bool hasValue = arg + 1 < argc;
+		if ((!strcmp(name, "-m") || !strcmp(name, "--mode")) && hasValue) mode = atoi(argv[++arg]);
+		else if ((!strcmp(name, "-p") || !strcmp(name, "--population")) && hasValue) world.populationSize = atoi(argv[++arg]);
+		else if (!strcmp(name, "--width") && hasValue) world.width = atoi(argv[++arg]);
+		else if (!strcmp(name, "--height") && hasValue) world.height = atoi(argv[++arg]);
+		else if ((!strcmp(name, "-c") || !strcmp(name, "--cells")) && hasValue) world.numCells = atoi(argv[++arg]);
+		else if ((!strcmp(name, "-t") || !strcmp(name, "--threads")) && hasValue) world.numThreads = atoi(argv[++arg]);
+		else if ((!strcmp(name, "-g") || !strcmp(name, "--generations")) && hasValue) numGenerations = (unsigned int)strtoul(argv[++arg], nullptr, 10);
+		else if ((!strcmp(name, "-s") || !strcmp(name, "--seed")) && hasValue) seed = strtoull(argv[++arg], nullptr, 10);
+		else if ((!strcmp(name, "-o") || !strcmp(name, "--output")) && hasValue) {
+			const std::string folder = argv[++arg];
+			outputFolder = std::wstring(folder.begin(), folder.end());
+		}
+		else if ((!strcmp(name, "-l") || !strcmp(name, "--load")) && hasValue) loadGeneration = (unsigned int)strtoul(argv[++arg], nullptr, 10);
+		else if (!strcmp(name, "-q") || !strcmp(name, "--quiet")) quiet = true;
+		else {
+			showUsage(argv[0]);
+			return (!strcmp(name, "-h") || !strcmp(name, "--help")) ? 0 : 1;
+		}
+	}
+	if (world.populationSize < 1) {
+		fprintf(stderr, "The population needs at least one lifeform\n");
+		return 1;
+	}
+	if ((world.width < 1) || (world.height < 1)) {
+		fprintf(stderr, "The world needs to be at least a pixel across\n");
+		return 1;
+	}
+	if (world.numCells < 0) {
+		fprintf(stderr, "The number of batteries can't be negative\n");
+		return 1;
+	}
+	if (world.numThreads < 0) {
+		fprintf(stderr, "The number of threads can't be negative\n");
+		return 1;
+	}
+	if ((loadGeneration > 0) && (outputFolder.empty())) {
+		fprintf(stderr, "--load needs the --output folder the snapshots are in\n");
+		return 1;
+	}
+
+	Experiment* simulation = createExperiment(mode, seed, world);
+	if (!simulation) {
+		fprintf(stderr, "There is no experiment mode %i\n", mode);
+		return 1;
+	}
+	unsigned int generation = 1;
+
+	if (loadGeneration > 0) {
+		GenStatistics lastGeneration;
+		unsigned int generationLoaded = loadGeneration;
+		if (!simulation->loadSnapshot(snapshotFilename(outputFolder, mode, loadGeneration), generationLoaded, lastGeneration)) {
+			fprintf(stderr, "Unable to load the snapshot of generation %u.  It's missing, cut short, or its brains aren't the shape mode %i uses\n",
+				loadGeneration, mode);
+			delete simulation;
+			return 1;
+		}
+		generation = generationLoaded + 1;
+	}
+
+	std::signal(SIGINT, onStopSignal);
+	std::signal(SIGTERM, onStopSignal);
+
+	if (!quiet) printf("Generation  Survivors  Iterations  Fitness\n");
+
+	const std::chrono::time_point<std::chrono::steady_clock> startTime = std::chrono::steady_clock::now();
+	unsigned long long totalSteps = 0;
+	unsigned int generationsRun = 0;
+	bool saveFailed = false;
+
+	while ((generationsRun < numGenerations) && (!g_stopRequested)) {
+		// Run fully
+		bool stillAlive = true;
+		while (stillAlive) {
+			stillAlive = simulation->step();
+			totalSteps++;
+		}
+
+		// Prepare the next one
+		GenStatistics stats;
+		simulation->produceNextGeneration(stats);
+		if (!quiet) {
+			printf("%10u  %9i  %10i  %7.3f\n", generation, stats.numSurvivors, stats.numIterations, stats.totalFitness);
+			fflush(stdout);
+		}
+
+		if ((!outputFolder.empty()) && (!simulation->saveSnapshot(snapshotFilename(outputFolder, mode, generation), generation, stats))) {
+			fprintf(stderr, "Unable to save the snapshot of generation %u\n", generation);
+			saveFailed = true;
+			break;
+		}
+
+		generation++;
+		generationsRun++;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	if (g_stopRequested) printf("Stopped early\n");
+	printf("Ran %u generations of mode %i (%llu steps) in %.2f seconds with seed %llu\n", generationsRun, mode, totalSteps, seconds, (unsigned long long)seed);
+	if (seconds > 0) printf("%.2f generations per second, %.0f steps per second\n", generationsRun / seconds, totalSteps / seconds);
+
+	delete simulation;
+	return saveFailed ? 1 : 0;
+}
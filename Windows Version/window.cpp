@@ -49,9 +49,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     
 // Create me
 CMainWindow::CMainWindow(HINSTANCE hInstance) : m_hInstance(hInstance) {
-    srand((unsigned int)time(NULL));
-       
-    m_simulation = new Simulation();
+    m_simulation = new Simulation<WindowMode>((uint64_t)time(NULL));
     
     m_cellPen = CreatePen(PS_SOLID, 1, RGB(255/2, 10/2, 10/2));
     m_sunPen = CreatePen(PS_SOLID, 1, RGB(255/2, 255/2, 128/2));
@@ -374,13 +372,11 @@ void CMainWindow::internalDraw(RECT* clientRect) {
         RECT r = { (LONG)(resource.position.x - resource.radius), (LONG)(resource.position.y - resource.radius) + yOffset ,
                    (LONG)(resource.position.x + resource.radius), (LONG)(resource.position.y + resource.radius) + yOffset };
 
-#ifdef TRACK_OTHERS
-        if (resource.shieldedBy>=0) {
+        if (WindowMode::trackOthers && (resource.shieldedBy>=0)) {
             SelectObject(m_canvasDC, m_shieldPen);
             SelectObject(m_canvasDC, m_shieldBrush);
             Ellipse(m_canvasDC, r.left-3, r.top-3, r.right+3, r.bottom+3);           
         }
-#endif
 
         switch (resource.resourceType) {
         case ResourceType::rtSunlight:
@@ -416,7 +412,7 @@ void CMainWindow::internalDraw(RECT* clientRect) {
 
 
     // Draw all lifeforms, this runs callback for each one
-    m_simulation->drawLifeforms([this, lifeformSize, &index, &numAlive, yOffset](const LifeformData& lifeform) {
+    m_simulation->drawLifeforms([this, lifeformSize, &index, &numAlive, yOffset](const LifeformData<WindowMode>& lifeform) {
         LifeformStatus status;
         lifeform.lifeForm->getDrawDetails(status);
 
@@ -451,16 +447,10 @@ void CMainWindow::internalDraw(RECT* clientRect) {
 
             // Draw lines to the nearest resource
             if (status.cellTargetAvailable) renderLine((LONG)status.positionX, (LONG)status.positionY + yOffset, (int)status.cellTarget.x, (int)status.cellTarget.y + yOffset, m_cellPenTarget);
-#ifdef USE_SOLAR
             if (status.sunTargetAvailable) renderLine((LONG)status.positionX, (LONG)status.positionY + yOffset, (int)status.sunTarget.x, (int)status.sunTarget.y + yOffset, m_sunPenTarget);
-#endif
-#ifdef HAS_QUICKSAND
             if (status.sandTargetAvailable) renderLine((LONG)status.positionX, (LONG)status.positionY + yOffset, (int)status.sandTarget.x, (int)status.sandTarget.y + yOffset, m_sandPenTarget);
-#endif
-#ifdef TRACK_OTHERS
             if (status.otherCompetitorFound)
                 renderLine((LONG)status.positionX, (LONG)status.positionY + yOffset, (int)status.otherCompetitor.x, (int)status.otherCompetitor.y + yOffset, m_lifeformTarget);
-#endif
         }
 
         index++;
@@ -480,7 +470,7 @@ void CMainWindow::internalDraw(RECT* clientRect) {
     LineTo(m_canvasDC, leftEdge + leftEdge, yPosition);
 
     // Draw the lines between lifeforms and resources
-    m_simulation->drawLifeforms([this, &index, &buffer, lifeformSize, leftEdge, &yPosition, rowHeight](const LifeformData& lifeform) {
+    m_simulation->drawLifeforms([this, &index, &buffer, lifeformSize, leftEdge, &yPosition, rowHeight](const LifeformData<WindowMode>& lifeform) {
         LifeformStatus status;
         lifeform.lifeForm->getDrawDetails(status);        
 
@@ -526,19 +516,20 @@ void CMainWindow::internalDraw(RECT* clientRect) {
             FillRect(m_canvasDC, &row, m_deadBrush);
         }
 
-#ifdef USE_SOLAR
-        row.bottom = row.top + (rowHeight / 2);
-        row.right = row.left + MulDiv(status.resources.sun, leftEdge - 34, MAX_SUN);
-        FillRect(m_canvasDC, &row, m_sunBrush);
-        row.top = row.bottom;
-        row.bottom = row.top + (rowHeight / 2);
-        row.right = row.left + MulDiv(status.resources.cell, leftEdge - 34, MAX_CELL);
-        FillRect(m_canvasDC, &row, m_cellBrush);
-#else
-        row.right = row.left + MulDiv(status.resources.cell, leftEdge - 34, MAX_CELL);
-        row.bottom++;
-        FillRect(m_canvasDC, &row, m_cellBrush);
-#endif
+        if (WindowMode::useSolar) {
+            row.bottom = row.top + (rowHeight / 2);
+            row.right = row.left + MulDiv(status.resources.sun, leftEdge - 34, MAX_SUN);
+            FillRect(m_canvasDC, &row, m_sunBrush);
+            row.top = row.bottom;
+            row.bottom = row.top + (rowHeight / 2);
+            row.right = row.left + MulDiv(status.resources.cell, leftEdge - 34, MAX_CELL);
+            FillRect(m_canvasDC, &row, m_cellBrush);
+        }
+        else {
+            row.right = row.left + MulDiv(status.resources.cell, leftEdge - 34, MAX_CELL);
+            row.bottom++;
+            FillRect(m_canvasDC, &row, m_cellBrush);
+        }
 
         yPosition += rowHeight + 1;
     });
@@ -616,8 +607,8 @@ void CMainWindow::internalDraw(RECT* clientRect) {
     
     graphOutput.bottom -= 2;
 
-    const int survivorScale = (graphOutput.bottom - graphOutput.top) / POPULATION_SIZE;
-    const float fitnessScale = (graphOutput.bottom - graphOutput.top) / (MAX_FITNESS * POPULATION_SIZE);
+    const int survivorScale = (graphOutput.bottom - graphOutput.top) / m_simulation->populationSize();
+    const float fitnessScale = (graphOutput.bottom - graphOutput.top) / (WindowMode::maxFitness * m_simulation->populationSize());
 
     int spacing = 4;
     // Shrink graph down as we get more data
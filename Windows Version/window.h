@@ -8,20 +8,21 @@
  *********************************************************************/
 #pragma once
 
-class Simulation;
-
 #include "Simulation.h"
 
 #include <thread>
 #include <vector>
 #include <chrono>
 
+// The window shows the experiment picked by EXPERIMENT_MODE in Simulation.h
+typedef ExperimentMode<EXPERIMENT_MODE> WindowMode;
+
 // Main window
 class CMainWindow {
 private:
 	HINSTANCE		m_hInstance;
 	HWND			m_hWnd = 0;
-	Simulation*		m_simulation = nullptr;
+	Simulation<WindowMode>* m_simulation = nullptr;
 	HBITMAP			m_canvas = 0;
 	HDC				m_canvasDC = 0;
 	HGDIOBJ			m_oldBitmap = 0;